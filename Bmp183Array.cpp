@@ -0,0 +1,241 @@
+/**
+ * \file Bmp183Array.cpp
+ *
+ *  Interleaved conversions across array members, and median or trimmed mean fusion.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Bmp183Array.h"
+
+// Pressure range of the BMP183 in Pa, outside of which a member is taken to have failed
+static const int32_t minValidPressure = 30000;
+static const int32_t maxValidPressure = 110000;
+
+Bmp183Array::Bmp183Array() {}
+
+Bmp183Array::~Bmp183Array() {
+    for (int i = 0; i < this->numMembers; i++) {
+        delete this->members[i];
+    }
+}
+
+/**
+ * Adds a sensor to the array. The array takes ownership of the driver, and deletes it when
+ * destroyed. Members should sit on their own bus or chip select.
+ * @return false if the array is full
+ */
+bool Bmp183Array::addMember(Bmp183Drv *member) {
+    if ((member == 0) || (this->numMembers >= maxArrayMembers)) {
+        std::cerr << "BMP183 array can't take more than " << maxArrayMembers << " sensors" << std::endl;
+        return false;
+    }
+    
+    this->members[this->numMembers++] = member;
+    
+    return true;
+}
+
+int Bmp183Array::getNumMembers() {
+    return this->numMembers;
+}
+
+Bmp183Drv* Bmp183Array::getMember(int index) {
+    if ((index < 0) || (index >= this->numMembers)) {
+        return 0;
+    }
+    
+    return this->members[index];
+}
+
+/**
+ * @param method median, or trimmed mean
+ * @param outlierThreshold how far in Pa a member may lie from the median before it is left out
+ * @return false if the threshold is not positive
+ */
+bool Bmp183Array::setFusion(bmp183_fusion_t method, int outlierThreshold) {
+    if (outlierThreshold <= 0) {
+        return false;
+    }
+    
+    this->method = method;
+    this->outlierThreshold = outlierThreshold;
+    
+    return true;
+}
+
+/**
+ * Reads every member at once and fuses the results.
+ * @param fused the fused sample to fill in
+ * @param members room for one sample per member, filled in with each member's diagnostics
+ * @return false if no member could be read
+ */
+bool Bmp183Array::read(bmp183_fused_sample &fused, bmp183_member_sample *members) {
+    Bmp183Conversion conversions[maxArrayMembers];
+    std::chrono::steady_clock::time_point due[maxArrayMembers];
+    int wait[maxArrayMembers];
+    
+    std::chrono::steady_clock::time_point now;
+    
+    // Members are started in index order, which keeps concurrent reads from deadlocking. Starting
+    // may wait on a member's bus, so each is due from the time its own conversion began.
+    for (int i = 0; i < this->numMembers; i++) {
+        // A member that fails to start, or fails partway, reports a zeroed sample
+        memset(&conversions[i].sample, 0, sizeof conversions[i].sample);
+        wait[i] = this->members[i]->isActive() ? this->members[i]->startConversion(conversions[i]) : -1;
+        due[i] = std::chrono::steady_clock::now() + std::chrono::microseconds(wait[i]);
+    }
+    
+    // Sleep until the next member is due, then step every member that is
+    for (;;) {
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+        
+        for (int i = 0; i < this->numMembers; i++) {
+            if ((wait[i] > 0) && (due[i] < next)) {
+                next = due[i];
+            }
+        }
+        
+        if (next == std::chrono::steady_clock::time_point::max()) {
+            break;
+        }
+        
+        std::chrono::steady_clock::time_point asleep = std::chrono::steady_clock::now();
+        {
+            trace::ScopedSpan span("array conversion wait", "conversion", "members", this->numMembers);
+            std::this_thread::sleep_until(next);
+        }
+        now = std::chrono::steady_clock::now();
+        
+        // The sleep is shared, so it counts as conversion wait for every member that was converting
+        if (stats::isEnabled()) {
+            uint64_t slept = std::chrono::duration_cast<std::chrono::microseconds>(now - asleep).count();
+            
+            for (int i = 0; i < this->numMembers; i++) {
+                if (wait[i] > 0) {
+                    this->members[i]->getStats().conversionWait.record(slept);
+                }
+            }
+        }
+        
+        for (int i = 0; i < this->numMembers; i++) {
+            if ((wait[i] > 0) && (due[i] <= now)) {
+                wait[i] = this->members[i]->continueConversion(conversions[i]);
+                due[i] = std::chrono::steady_clock::now() + std::chrono::microseconds(wait[i]);
+            }
+        }
+    }
+    
+    for (int i = 0; i < this->numMembers; i++) {
+        members[i].sample = conversions[i].sample;
+        members[i].status = (wait[i] == 0) ? BMP183_MEMBER_FUSED : BMP183_MEMBER_FAILED;
+    }
+    
+    fuse((bmp183_fusion_t)this->method.load(), this->outlierThreshold, this->numMembers, members, fused);
+    
+    return (fused.fused > 0);
+}
+
+/**
+ * Fuses the samples of the members that were read. With three or more, those further than the
+ * threshold from the median pressure are marked as outliers first, unless that would leave none.
+ * @param count the number of members
+ * @param members the member samples, with the status of those that failed already set
+ * @param fused the fused sample to fill in
+ */
+void Bmp183Array::fuse(bmp183_fusion_t method, int outlierThreshold, int count, bmp183_member_sample *members, bmp183_fused_sample &fused) {
+    int32_t pressures[maxArrayMembers];
+    int32_t temperatures[maxArrayMembers];
+    int valid = 0;
+    
+    fused.timestamp = 0;
+    fused.pressure = 0;
+    fused.temperature = 0;
+    fused.fused = 0;
+    
+    for (int i = 0; i < count; i++) {
+        if ((members[i].sample.pressure < minValidPressure) || (members[i].sample.pressure > maxValidPressure)) {
+            members[i].status = BMP183_MEMBER_FAILED;
+        }
+        
+        members[i].deviation = 0;
+        
+        if (members[i].status != BMP183_MEMBER_FAILED) {
+            pressures[valid++] = members[i].sample.pressure;
+        }
+    }
+    
+    if (valid == 0) {
+        return;
+    }
+    
+    // Two members can't outvote each other
+    if (valid >= 3) {
+        int32_t median = combine(BMP183_FUSION_MEDIAN, pressures, valid);
+        int agreeing = 0;
+        
+        for (int i = 0; i < count; i++) {
+            if ((members[i].status != BMP183_MEMBER_FAILED) && (abs(members[i].sample.pressure - median) <= outlierThreshold)) {
+                agreeing++;
+            }
+        }
+        
+        for (int i = 0; (i < count) && (agreeing > 0); i++) {
+            if ((members[i].status != BMP183_MEMBER_FAILED) && (abs(members[i].sample.pressure - median) > outlierThreshold)) {
+                members[i].status = BMP183_MEMBER_OUTLIER;
+            }
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        if (members[i].status == BMP183_MEMBER_FUSED) {
+            pressures[fused.fused] = members[i].sample.pressure;
+            temperatures[fused.fused] = members[i].sample.temperature;
+            fused.fused++;
+            
+            if (members[i].sample.timestamp > fused.timestamp) {
+                fused.timestamp = members[i].sample.timestamp;
+            }
+        }
+    }
+    
+    fused.pressure = combine(method, pressures, fused.fused);
+    fused.temperature = combine(method, temperatures, fused.fused);
+    
+    for (int i = 0; i < count; i++) {
+        if (members[i].status != BMP183_MEMBER_FAILED) {
+            members[i].deviation = members[i].sample.pressure - fused.pressure;
+        }
+    }
+}
+
+// Median, or mean without the highest and lowest quarter, of a few values, which are sorted in place
+int32_t Bmp183Array::combine(bmp183_fusion_t method, int32_t *values, int count) {
+    for (int i = 1; i < count; i++) {
+        int32_t value = values[i];
+        int j = i;
+        
+        for (; (j > 0) && (values[j - 1] > value); j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+    
+    int trim = (method == BMP183_FUSION_MEDIAN) ? (count - 1) / 2 : count / 4;
+    int64_t sum = 0;
+    
+    for (int i = trim; i < count - trim; i++) {
+        sum += values[i];
+    }
+    
+    int kept = count - 2 * trim;
+    
+    return (int32_t)((sum >= 0) ? (sum + kept / 2) / kept : (sum - kept / 2) / kept);
+}
@@ -0,0 +1,99 @@
+/**
+ * \file Bmp183Array.h
+ *
+ *  Arrays of sensors converting together, with fused readings.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __Bmp183Array__
+#define __Bmp183Array__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Bmp183Drv.h"
+
+/*=========================================================================
+ FUSED SAMPLES
+ -----------------------------------------------------------------------*/
+typedef enum
+{
+    BMP183_FUSION_MEDIAN = 0,
+    BMP183_FUSION_TRIMMED_MEAN
+} bmp183_fusion_t;
+
+typedef enum
+{
+    BMP183_MEMBER_FUSED = 0,            // agreed with the array and was fused
+    BMP183_MEMBER_OUTLIER,              // disagreed with the array and was left out
+    BMP183_MEMBER_FAILED                // could not be read
+} bmp183_member_status_t;
+
+typedef struct
+{
+    int64_t  timestamp;                 // microseconds since the epoch, of the last member read
+    int32_t  pressure;                  // fused station pressure in Pa
+    int32_t  temperature;               // fused temperature in 0.01 C
+    uint8_t  fused;                     // number of members fused
+} bmp183_fused_sample;
+
+typedef struct
+{
+    bmp183_sample sample;               // as converted by the member
+    uint8_t  status;                    // bmp183_member_status_t
+    int32_t  deviation;                 // member pressure less the fused pressure, in Pa
+} bmp183_member_sample;
+
+static const int maxArrayMembers = 8;
+/*=========================================================================*/
+
+/**
+ * @class Bmp183Array
+ * @brief Several BMP183s at one station, read at once and fused into one sample.
+ *
+ * Conversions are split-phase: every member starts its conversion, the array sleeps once until
+ * the first is due, and reads each member as it completes, so the whole array takes about as long
+ * as its slowest member. With three or more members read, any whose pressure lies further than
+ * the outlier threshold from the median is left out, and the rest are fused by median or by
+ * trimmed mean, which drops the highest and lowest quarter.
+ */
+class Bmp183Array {
+    
+public:
+    
+    Bmp183Array();
+    ~Bmp183Array();
+    
+    bool addMember(Bmp183Drv *member);
+    int getNumMembers();
+    Bmp183Drv* getMember(int index);
+    
+    bool setFusion(bmp183_fusion_t method, int outlierThreshold);
+    bool read(bmp183_fused_sample &fused, bmp183_member_sample *members);
+    
+    static void fuse(bmp183_fusion_t method, int outlierThreshold, int count, bmp183_member_sample *members, bmp183_fused_sample &fused);
+    
+private:
+    
+    static int32_t combine(bmp183_fusion_t method, int32_t *values, int count);
+    
+    Bmp183Drv *members[maxArrayMembers];
+    int numMembers = 0;
+    
+    // Set from JS while a read may be under way on a worker
+    std::atomic<int> method{BMP183_FUSION_MEDIAN};
+    std::atomic<int> outlierThreshold{100};
+    
+};
+
+#endif /* __Bmp183Array__ */
@@ -0,0 +1,224 @@
+/**
+ * \file Bmp183ArrayNode.cpp
+ *
+ *  JS methods of the Bmp183Array class.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Bmp183ArrayNode.h"
+#include "Bmp183Node.h"
+
+namespace bmp183 {
+    
+    using v8::FunctionCallbackInfo;
+    using v8::FunctionTemplate;
+    using v8::Function;
+    using v8::Persistent;
+    using v8::Isolate;
+    using v8::Local;
+    using v8::Handle;
+    using v8::Object;
+    using v8::String;
+    using v8::Value;
+    using v8::Number;
+    using v8::Boolean;
+    using v8::Array;
+    
+    Persistent<Function> Bmp183ArrayNode::constructor;
+    
+    void Bmp183ArrayNode::Init(Local<Object> exports) {
+        Isolate* isolate = exports->GetIsolate();
+        
+        Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+        
+        tpl->SetClassName(String::NewFromUtf8(isolate, "Bmp183Array"));
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+        
+        NODE_SET_PROTOTYPE_METHOD(tpl, "numSensors", getNumSensors);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "fusion", setFusion);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "stationAltitude", setStationAltitude);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "readSync", readSync);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "read", read);
+        
+        constructor.Reset(isolate, tpl->GetFunction());
+        
+        exports->Set(String::NewFromUtf8(isolate, "Bmp183Array"), tpl->GetFunction());
+    }
+    
+    // new Bmp183Array(['/dev/spidev1.0', '/dev/spidev1.1', '/dev/spidev2.0'], altitude, mode)
+    void Bmp183ArrayNode::New(const FunctionCallbackInfo<Value>& args) {
+        
+        int altitude = args[1]->IsUndefined() ? 0 : args[1]->NumberValue();
+        int mode = args[2]->IsUndefined() ? 3 : args[2]->NumberValue();
+        
+        Bmp183ArrayNode* obj = new Bmp183ArrayNode();
+        
+        if (args[0]->IsArray()) {
+            Local<Array> devfiles = Local<Array>::Cast(args[0]);
+            
+            for (uint32_t i = 0; i < devfiles->Length(); i++) {
+                std::string devfile = *v8::String::Utf8Value(devfiles->Get(i)->ToString());
+                Bmp183Drv *member = Bmp183Drv::create(devfile, altitude, mode);
+                
+                if (!obj->array.addMember(member)) {
+                    delete member;
+                }
+            }
+        }
+        
+        obj->Wrap(args.This());
+        
+        args.GetReturnValue().Set(args.This());
+    }
+    
+    void Bmp183ArrayNode::getNumSensors (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        Bmp183ArrayNode* obj = ObjectWrap::Unwrap<Bmp183ArrayNode>(args.Holder());
+        
+        Local<Number> numSensors = Number::New(isolate, obj->array.getNumMembers());
+        
+        args.GetReturnValue().Set(numSensors);
+    }
+    
+    // fusion('median' or 'trimmed', outlierThreshold in hPa)
+    void Bmp183ArrayNode::setFusion (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        Bmp183ArrayNode* obj = ObjectWrap::Unwrap<Bmp183ArrayNode>(args.Holder());
+        
+        std::string method = args[0]->IsUndefined() ? "median" : *v8::String::Utf8Value(args[0]->ToString());
+        int threshold = args[1]->IsUndefined() ? 100 : (int)lround(args[1]->NumberValue() * 100);
+        bool result = false;
+        
+        if (method == "median") {
+            result = obj->array.setFusion(BMP183_FUSION_MEDIAN, threshold);
+        }
+        else if (method == "trimmed") {
+            result = obj->array.setFusion(BMP183_FUSION_TRIMMED_MEAN, threshold);
+        }
+        
+        args.GetReturnValue().Set(Boolean::New(isolate, result));
+    }
+    
+    // Changes the altitude of every sensor in meters, if given, and returns the altitude in use
+    void Bmp183ArrayNode::setStationAltitude (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        Bmp183ArrayNode* obj = ObjectWrap::Unwrap<Bmp183ArrayNode>(args.Holder());
+        
+        for (int i = 0; (i < obj->array.getNumMembers()) && !args[0]->IsUndefined(); i++) {
+            obj->array.getMember(i)->setStationAltitude(args[0]->Int32Value());
+        }
+        
+        int altitude = (obj->array.getNumMembers() > 0) ? obj->array.getMember(0)->getStationAltitude() : 0;
+        
+        args.GetReturnValue().Set(Number::New(isolate, altitude));
+    }
+    
+    void Bmp183ArrayNode::readSync (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        Bmp183ArrayNode* obj = ObjectWrap::Unwrap<Bmp183ArrayNode>(args.Holder());
+        
+        bmp183_fused_sample fused;
+        bmp183_member_sample members[maxArrayMembers];
+        
+        if (!obj->array.read(fused, members)) {
+            args.GetReturnValue().Set(Undefined(isolate));
+            return;
+        }
+        
+        args.GetReturnValue().Set(resultObject(isolate, obj->array, fused, members));
+    }
+    
+    void Bmp183ArrayNode::read (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        Bmp183ArrayNode* obj = ObjectWrap::Unwrap<Bmp183ArrayNode>(args.Holder());
+        
+        Work * work = new Work();
+        work->request.data = work;
+        work->node = obj;
+        
+        Local<Function> callback = Local<Function>::Cast(args[0]);
+        work->callback.Reset(isolate, callback);
+        
+        // Keep the array alive until the read completes
+        obj->Ref();
+        
+        uv_queue_work(uv_default_loop(),&work->request,WorkAsync,WorkAsyncComplete);
+        
+        args.GetReturnValue().Set(Undefined(isolate));
+    }
+    
+    // Describes a fused sample and each sensor's part in it, with pressures adjusted to sea level
+    Local<Object> Bmp183ArrayNode::resultObject(Isolate* isolate, Bmp183Array &array, const bmp183_fused_sample &fused, const bmp183_member_sample *members) {
+        static const char *statusNames[3] = { "fused", "outlier", "failed" };
+        
+        int altitude = (array.getNumMembers() > 0) ? array.getMember(0)->getStationAltitude() : 0;
+        
+        Local<Object> result = Object::New(isolate);
+        result->Set(String::NewFromUtf8(isolate, "pressure"), Number::New(isolate, Bmp183Drv::seaLevelPressure(fused.pressure / 100.0F, altitude)));
+        result->Set(String::NewFromUtf8(isolate, "temperature"), Number::New(isolate, fused.temperature / 100.0));
+        result->Set(String::NewFromUtf8(isolate, "timestamp"), Number::New(isolate, fused.timestamp / 1000.0));
+        result->Set(String::NewFromUtf8(isolate, "fused"), Number::New(isolate, fused.fused));
+        
+        Local<Array> sensors = Array::New(isolate, array.getNumMembers());
+        for (int i = 0; i < array.getNumMembers(); i++) {
+            const bmp183_member_sample &member = members[i];
+            Local<Object> sensor = Object::New(isolate);
+            bool failed = (member.status == BMP183_MEMBER_FAILED);
+            
+            sensor->Set(String::NewFromUtf8(isolate, "status"), String::NewFromUtf8(isolate, statusNames[member.status]));
+            sensor->Set(String::NewFromUtf8(isolate, "pressure"), Number::New(isolate, failed ? NAN : Bmp183Drv::seaLevelPressure(member.sample.pressure / 100.0F, altitude)));
+            sensor->Set(String::NewFromUtf8(isolate, "temperature"), Number::New(isolate, failed ? NAN : member.sample.temperature / 100.0));
+            sensor->Set(String::NewFromUtf8(isolate, "deviation"), Number::New(isolate, member.deviation / 100.0));
+            sensor->Set(String::NewFromUtf8(isolate, "mode"), Number::New(isolate, member.sample.mode));
+            sensors->Set(i, sensor);
+        }
+        result->Set(String::NewFromUtf8(isolate, "sensors"), sensors);
+        
+        return result;
+    }
+    
+    // called by libuv worker in separate thread
+    void Bmp183ArrayNode::WorkAsync(uv_work_t *req) {
+        Work *work = static_cast<Work *>(req->data);
+        
+        work->success = work->node->array.read(work->fused, work->members);
+    }
+    
+    // called by libuv in event loop when async function completes
+    void Bmp183ArrayNode::WorkAsyncComplete(uv_work_t *req, int status) {
+        Isolate * isolate = Isolate::GetCurrent();
+        
+        v8::HandleScope handleScope(isolate);
+        
+        Work *work = static_cast<Work *>(req->data);
+        
+        Local<Value> error = Null(isolate);
+        Local<Value> result = Undefined(isolate);
+        
+        if (work->success) {
+            result = resultObject(isolate, work->node->array, work->fused, work->members);
+        }
+        else {
+            error = v8::Exception::Error(String::NewFromUtf8(isolate, "No BMP183 in the array could be read"));
+        }
+        
+        // set up return arguments: 0 = error, 1 = fused sample
+        Handle<Value> argv[] = { error, result };
+        
+        Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), 2, argv);
+        
+        work->node->Unref();
+        work->callback.Reset();
+        delete work;
+        
+    }
+    
+}  // namespace bmp183
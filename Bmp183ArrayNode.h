@@ -0,0 +1,75 @@
+/**
+ * \file Bmp183ArrayNode.h
+ *
+ *  Node binding of sensor arrays.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __Bmp183ArrayNode__
+#define __Bmp183ArrayNode__
+
+#include <node.h>
+#include <node_object_wrap.h>
+#include <uv.h>
+#include <string>
+#include "Bmp183Array.h"
+
+namespace bmp183 {
+    
+/**
+ * @class Bmp183ArrayNode
+ * @brief The Bmp183Array JS class, fusing several sensors at one station. Unlike Bmp183, each
+ * instance owns its own sensors.
+ */
+class Bmp183ArrayNode : public node::ObjectWrap {
+ 
+public:
+    static void Init(v8::Local<v8::Object> exports);
+    
+    static void getNumSensors (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setFusion (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setStationAltitude (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void readSync (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void read (const v8::FunctionCallbackInfo<v8::Value>& args);
+    
+private:
+    
+    explicit Bmp183ArrayNode() {}
+    
+    ~Bmp183ArrayNode() {}
+    
+    static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+    
+    static void WorkAsync(uv_work_t *req);
+    static void WorkAsyncComplete(uv_work_t *req,int status);
+    
+    static v8::Local<v8::Object> resultObject(v8::Isolate* isolate, Bmp183Array &array, const bmp183_fused_sample &fused, const bmp183_member_sample *members);
+    
+    static v8::Persistent<v8::Function> constructor;
+    
+    Bmp183Array array;
+    
+    struct Work {
+        uv_work_t  request;
+        v8::Persistent<v8::Function> callback;
+        
+        Bmp183ArrayNode *node;
+        bool success;
+        bmp183_fused_sample fused;
+        bmp183_member_sample members[maxArrayMembers];
+    };
+    
+};
+    
+} // namespace
+
+
+#endif /* defined(__Bmp183ArrayNode__) */
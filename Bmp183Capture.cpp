@@ -0,0 +1,319 @@
+/**
+ * \file Bmp183Capture.cpp
+ *
+ *  Buffered capture recording and memory mapped replay.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Bmp183Capture.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+Bmp183Recorder::Bmp183Recorder() {
+    this->file = -1;
+    this->buffered = 0;
+    this->closing = false;
+}
+
+Bmp183Recorder::~Bmp183Recorder() {
+    this->close();
+}
+
+/**
+ * Opens a capture file for appending, writing the header if the file is new. An existing
+ * capture is only appended to if it came from a device with the same calibration, and any
+ * partial record left at its end by a crash is trimmed away first, so that the records
+ * which follow stay aligned.
+ * @return false if the file cannot be opened or belongs to a different device
+ */
+bool Bmp183Recorder::open(std::string filename, const bmp183_calib_data &calibration) {
+    this->close();
+    
+    int fd = ::open(filename.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    
+    if (fd < 0) {
+        std::cerr << "Bmp183Recorder: Can't open capture " << filename << std::endl;
+        return false;
+    }
+    
+    bmp183_capture_header header;
+    ssize_t length = ::pread(fd, &header, sizeof header, 0);
+    
+    if (length == 0) {
+        memset(&header, 0, sizeof header);
+        memcpy(header.magic, captureMagic, sizeof header.magic);
+        header.version = captureVersion;
+        header.recordSize = sizeof(bmp183_capture_record);
+        header.calibration = calibration;
+        
+        if (::write(fd, &header, sizeof header) != sizeof header) {
+            std::cerr << "Bmp183Recorder: Can't write capture header" << std::endl;
+            ::close(fd);
+            return false;
+        }
+    }
+    else if ((length != sizeof header) || (memcmp(header.magic, captureMagic, sizeof header.magic) != 0) ||
+             (header.version != captureVersion) || (header.recordSize != sizeof(bmp183_capture_record)) ||
+             (memcmp(&header.calibration, &calibration, sizeof calibration) != 0)) {
+        std::cerr << "Bmp183Recorder: " << filename << " is not a capture from this device" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    else {
+        struct stat status;
+        
+        if (fstat(fd, &status) < 0) {
+            std::cerr << "Bmp183Recorder: Can't stat capture " << filename << std::endl;
+            ::close(fd);
+            return false;
+        }
+        
+        size_t records = ((size_t)status.st_size - sizeof header) / sizeof(bmp183_capture_record);
+        off_t whole = sizeof header + records * sizeof(bmp183_capture_record);
+        
+        if ((whole != status.st_size) && (ftruncate(fd, whole) < 0)) {
+            std::cerr << "Bmp183Recorder: Can't trim partial record from " << filename << std::endl;
+            ::close(fd);
+            return false;
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->recorderMutex);
+        this->file = fd;
+        this->closing = false;
+        this->lastFlush = std::chrono::steady_clock::now();
+    }
+    
+    this->flusher = std::thread(&Bmp183Recorder::flushLoop, this);
+    
+    return true;
+}
+
+bool Bmp183Recorder::record(const bmp183_sample &sample) {
+    std::lock_guard<std::mutex> lock(this->recorderMutex);
+    
+    if (this->file < 0) {
+        return false;
+    }
+    
+    bmp183_capture_record &record = this->buffer[this->buffered++];
+    record.timestamp = sample.timestamp;
+    record.rawPressure = sample.rawPressure;
+    record.rawTemperature = sample.rawTemperature;
+    record.mode = sample.mode;
+    record.flags = 0;
+    
+    if (this->buffered == bufferRecords) {
+        return this->writeBuffer();
+    }
+    
+    return true;
+}
+
+/**
+ * Writes any buffered records to the file
+ */
+bool Bmp183Recorder::flush() {
+    std::lock_guard<std::mutex> lock(this->recorderMutex);
+    return this->writeBuffer();
+}
+
+// Writes the buffer, with recorderMutex held
+bool Bmp183Recorder::writeBuffer() {
+    this->lastFlush = std::chrono::steady_clock::now();
+    
+    if ((this->file < 0) || (this->buffered == 0)) {
+        return true;
+    }
+    
+    size_t length = this->buffered * sizeof(bmp183_capture_record);
+    bool written = (::write(this->file, this->buffer, length) == (ssize_t)length);
+    
+    if (!written) {
+        std::cerr << "Bmp183Recorder: Can't write capture records" << std::endl;
+    }
+    
+    this->buffered = 0;
+    
+    return written;
+}
+
+// Writes out records left in the buffer a second after the last write, until closed
+void Bmp183Recorder::flushLoop() {
+    std::unique_lock<std::mutex> lock(this->recorderMutex);
+    
+    while (!this->closing) {
+        std::chrono::steady_clock::time_point due = this->lastFlush + std::chrono::milliseconds(flushInterval);
+        
+        if (this->flushSignal.wait_until(lock, due, [this] { return this->closing; })) {
+            break;
+        }
+        
+        // A write by record pushes the next one back
+        if (std::chrono::steady_clock::now() >= this->lastFlush + std::chrono::milliseconds(flushInterval)) {
+            this->writeBuffer();
+        }
+    }
+}
+
+void Bmp183Recorder::close() {
+    {
+        std::lock_guard<std::mutex> lock(this->recorderMutex);
+        this->closing = true;
+    }
+    
+    this->flushSignal.notify_all();
+    
+    if (this->flusher.joinable()) {
+        this->flusher.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(this->recorderMutex);
+    
+    if (this->file >= 0) {
+        this->writeBuffer();
+        ::close(this->file);
+        this->file = -1;
+    }
+}
+
+bool Bmp183Recorder::isOpen() {
+    std::lock_guard<std::mutex> lock(this->recorderMutex);
+    return (this->file >= 0);
+}
+
+Bmp183Replay::Bmp183Replay() {
+    this->mapping = MAP_FAILED;
+    this->mappingSize = 0;
+    this->header = 0;
+    this->records = 0;
+    this->count = 0;
+}
+
+Bmp183Replay::~Bmp183Replay() {
+    this->close();
+}
+
+/**
+ * Maps a capture file for replay
+ * @return false if the file cannot be mapped or is not a capture
+ */
+bool Bmp183Replay::open(std::string filename) {
+    this->close();
+    
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    
+    if (fd < 0) {
+        std::cerr << "Bmp183Replay: Can't open capture " << filename << std::endl;
+        return false;
+    }
+    
+    struct stat status;
+    if ((fstat(fd, &status) < 0) || ((size_t)status.st_size < sizeof(bmp183_capture_header))) {
+        std::cerr << "Bmp183Replay: " << filename << " is too short for a capture" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    
+    void *mapped = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Bmp183Replay: Can't map capture " << filename << std::endl;
+        return false;
+    }
+    
+    const bmp183_capture_header *mappedHeader = (const bmp183_capture_header *)mapped;
+    
+    if ((memcmp(mappedHeader->magic, captureMagic, sizeof mappedHeader->magic) != 0) ||
+        (mappedHeader->version != captureVersion) || (mappedHeader->recordSize != sizeof(bmp183_capture_record))) {
+        std::cerr << "Bmp183Replay: " << filename << " is not a capture" << std::endl;
+        munmap(mapped, status.st_size);
+        return false;
+    }
+    
+    // Replay reads front to back, so let the kernel read ahead aggressively
+    madvise(mapped, status.st_size, MADV_SEQUENTIAL);
+    
+    this->mapping = mapped;
+    this->mappingSize = status.st_size;
+    this->header = mappedHeader;
+    this->records = (const bmp183_capture_record *)((const char *)mapped + sizeof(bmp183_capture_header));
+    this->count = (status.st_size - sizeof(bmp183_capture_header)) / sizeof(bmp183_capture_record);
+    
+    return true;
+}
+
+void Bmp183Replay::close() {
+    if (this->mapping != MAP_FAILED) {
+        munmap(this->mapping, this->mappingSize);
+    }
+    
+    this->mapping = MAP_FAILED;
+    this->mappingSize = 0;
+    this->header = 0;
+    this->records = 0;
+    this->count = 0;
+}
+
+size_t Bmp183Replay::size() {
+    return this->count;
+}
+
+const bmp183_calib_data& Bmp183Replay::getCalibration() {
+    return this->header->calibration;
+}
+
+/**
+ * Sets the filter replayed samples pass through after compensation, starting afresh
+ */
+void Bmp183Replay::setFilter(const SampleFilter &filter) {
+    this->filter = filter;
+    this->filter.reset();
+}
+
+bool Bmp183Replay::getSample(size_t index, bmp183_sample &sample) {
+    if (index >= this->count) {
+        return false;
+    }
+    
+    this->decode(this->records[index], sample);
+    
+    return true;
+}
+
+/**
+ * Compensates a run of records into an array of samples
+ * @return the number of samples filled in
+ */
+size_t Bmp183Replay::getSamples(size_t from, bmp183_sample *samples, size_t count) {
+    size_t filled = 0;
+    
+    while ((filled < count) && (from + filled < this->count)) {
+        this->decode(this->records[from + filled], samples[filled]);
+        filled++;
+    }
+    
+    return filled;
+}
+
+void Bmp183Replay::decode(const bmp183_capture_record &record, bmp183_sample &sample) {
+    sample.timestamp = record.timestamp;
+    sample.rawTemperature = record.rawTemperature;
+    sample.rawPressure = record.rawPressure;
+    sample.mode = record.mode;
+    
+    Bmp183Drv::compensate(this->header->calibration, sample);
+    Bmp183Drv::filter(this->filter, sample);
+}
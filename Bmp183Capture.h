@@ -0,0 +1,150 @@
+/**
+ * \file Bmp183Capture.h
+ *
+ *  Raw sample capture files, and their replay through compensation.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __Bmp183Capture__
+#define __Bmp183Capture__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "Bmp183Drv.h"
+
+/*=========================================================================
+ CAPTURE FILE FORMAT
+ -----------------------------------------------------------------------
+ A capture is a 64 byte header followed by fixed size records, appended
+ as samples are taken. A partial record at the end, left by a crash, is
+ ignored on replay. All fields are in host byte order.
+ -----------------------------------------------------------------------*/
+static const char captureMagic[8] = { 'B', 'M', 'P', '1', '8', '3', 'R', 'C' };
+static const uint32_t captureVersion = 1;
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    bmp183_calib_data calibration;
+    uint8_t  reserved[64 - 16 - sizeof(bmp183_calib_data)];
+} bmp183_capture_header;
+
+typedef struct
+{
+    int64_t  timestamp;         // microseconds since the epoch
+    uint32_t rawPressure;       // UP
+    uint16_t rawTemperature;    // UT
+    uint8_t  mode;              // bmp183_mode_t of the pressure conversion
+    uint8_t  flags;             // reserved, zero
+} bmp183_capture_record;
+/*=========================================================================*/
+
+/**
+ * @class Bmp183Recorder
+ * @brief Appends raw samples to a capture file, buffering records to keep write calls rare.
+ *
+ * Buffered records are written once the buffer fills, and a thread writes whatever is buffered
+ * a second after the last write, so a crash loses at most about a second of samples however
+ * slowly they arrive.
+ */
+class Bmp183Recorder {
+    
+public:
+    Bmp183Recorder();
+    ~Bmp183Recorder();
+    
+    bool open(std::string filename, const bmp183_calib_data &calibration);
+    bool record(const bmp183_sample &sample);
+    bool flush();
+    void close();
+    bool isOpen();
+    
+private:
+    static const int bufferRecords = 256;
+    static const int flushInterval = 1000;     // milliseconds
+    
+    bool writeBuffer();
+    void flushLoop();
+    
+    int file;
+    int buffered;
+    std::chrono::steady_clock::time_point lastFlush;
+    bmp183_capture_record buffer[bufferRecords];
+    
+    // Guards the file and buffer between the recording thread and the flusher
+    std::mutex recorderMutex;
+    std::condition_variable flushSignal;
+    std::thread flusher;
+    bool closing;
+};
+
+/**
+ * @class Bmp183Replay
+ * @brief Memory maps a capture file and feeds its raw samples through compensation and filtering at full CPU speed.
+ *
+ * The filter keeps its state from one sample to the next, so samples should be taken in order
+ * when a filter is set.
+ */
+class Bmp183Replay {
+    
+public:
+    Bmp183Replay();
+    ~Bmp183Replay();
+    
+    bool open(std::string filename);
+    void close();
+    
+    size_t size();
+    const bmp183_calib_data& getCalibration();
+    void setFilter(const SampleFilter &filter);
+    bool getSample(size_t index, bmp183_sample &sample);
+    size_t getSamples(size_t from, bmp183_sample *samples, size_t count);
+    
+    /**
+     * Compensates and filters every record in turn and passes the resulting sample to sink, which may
+     * return false to stop early.
+     * @return the number of samples passed to sink
+     */
+    template<class Sink>
+    size_t replay(Sink sink) {
+        bmp183_sample sample;
+        
+        this->filter.reset();
+        
+        for (size_t i = 0; i < this->count; i++) {
+            this->decode(this->records[i], sample);
+            if (!sink(sample)) {
+                return i + 1;
+            }
+        }
+        
+        return this->count;
+    }
+    
+private:
+    void decode(const bmp183_capture_record &record, bmp183_sample &sample);
+    
+    void *mapping;
+    size_t mappingSize;
+    const bmp183_capture_header *header;
+    const bmp183_capture_record *records;
+    size_t count;
+    SampleFilter filter;
+};
+
+#endif /* __Bmp183Capture__ */
@@ -13,70 +13,120 @@
  */
 
 #include "Bmp183Drv.h"
+#include "Bmp183Emulator.h"
+#include "I2CDevice.h"
+#include "Bmp183Capture.h"
+#include "HistoryStore.h"
+#include "TelemetryEncoder.h"
 
-Bmp183Drv::Bmp183Drv(std::string devfile):spibus::SPIDevice(devfile) {
+constexpr sensor::SensorDescriptor<Bmp183Drv, numValues> Bmp183Drv::descriptor;
 
-    this->stationAltitude = 0;
-    this->operatingMode = BMP183_MODE_ULTRAHIGHRES;
+Bmp183Drv::Bmp183Drv(std::string devfile) {
+    
+    this->device = new spibus::SPIDevice(devfile);
+
+    this->configure(0, BMP183_MODE_ULTRAHIGHRES);
     
     this->activate();
 }
 
-Bmp183Drv::Bmp183Drv(std::string devfile, int altitude):spibus::SPIDevice(devfile) {
+Bmp183Drv::Bmp183Drv(std::string devfile, int altitude) {
+    
+    this->device = new spibus::SPIDevice(devfile);
 
-    this->stationAltitude = altitude;
-    this->operatingMode = BMP183_MODE_ULTRAHIGHRES;
+    this->configure(altitude, BMP183_MODE_ULTRAHIGHRES);
     
     this->activate();
 }
 
-Bmp183Drv::Bmp183Drv(std::string devfile, int altitude, int operationMode):spibus::SPIDevice(devfile) {
+Bmp183Drv::Bmp183Drv(std::string devfile, int altitude, int operationMode) {
     
-    this->stationAltitude = altitude;
-    this->operatingMode = (bmp183_mode_t)operationMode;
+    this->device = new spibus::SPIDevice(devfile);
+    this->configure(altitude, operationMode);
     
     this->activate();
 }
 
+/**
+ * Constructs the driver on an already created device, such as a Bmp183Emulator.
+ * The driver takes ownership of the device, and deletes it when destroyed.
+ */
+Bmp183Drv::Bmp183Drv(bus::BusDevice *device, int altitude, int operationMode) {
+    
+    this->device = device;
+    this->configure(altitude, operationMode);
+    
+    this->activate();
+}
+
+/**
+ * Creates the driver for a device file, on the bus its path names. "emulator" stands in for
+ * hardware, for testing and benchmarking, and a path under /dev/i2c is taken to be a BMP085 or
+ * BMP180, which always answers at address 0x77. Anything else is a BMP183 on SPI.
+ */
+Bmp183Drv* Bmp183Drv::create(std::string devfile, int altitude, int operationMode) {
+    if (devfile == "emulator") {
+        return new Bmp183Drv(new Bmp183Emulator(), altitude, operationMode);
+    }
+    else if (devfile.compare(0, 8, "/dev/i2c") == 0) {
+        return new Bmp183Drv(new i2cbus::I2CDevice(devfile, 0x77), altitude, operationMode);
+    }
+    else {
+        return new Bmp183Drv(devfile, altitude, operationMode);
+    }
+}
+
+Bmp183Drv::~Bmp183Drv() {
+    this->stopWorker();
+    this->stopRecording();
+    this->closeHistory();
+    
+    if (this->sampleEventFd >= 0) {
+        close(this->sampleEventFd);
+    }
+    
+    delete this->device;
+}
+
 void Bmp183Drv::activate() {
     if (initialize()) {
         this->active = true;
     }
     else {
-        std::cerr << name << " did not initialize. " << name << " is inactive" << std::endl;
+        std::cerr << descriptor.name.data() << " did not initialize. " << descriptor.name.data() << " is inactive" << std::endl;
     }
 }
 
 std::string Bmp183Drv::getVersion() {
-    return name + " " + version;
+    return descriptor.name.str() + " " + descriptor.version.str();
 }
 
 std::string Bmp183Drv::getDeviceName() {
-    return name;
+    return descriptor.name.str();
 }
 
 std::string Bmp183Drv::getDeviceType() {
-    return type;
+    return descriptor.type.str();
 }
 
 int Bmp183Drv::getNumValues() {
-    return numValues;
+    return descriptor.numValues();
 }
 
 std::string Bmp183Drv::getTypeAtIndex(int index) {
-    if ((index < 0) || (index > (numValues - 1))) {
+    if (!descriptor.contains(index)) {
         return "none";
     }
     
-    return valueTypes[index];
+    return descriptor.values[index].type.str();
 }
 
 std::string Bmp183Drv::getNameAtIndex(int index) {
-    if ((index < 0) || (index > (numValues - 1))) {
+    if (!descriptor.contains(index)) {
         return "none";
     }
     
-    return valueNames[index];
+    return descriptor.values[index].name.str();
 }
 
 bool Bmp183Drv::isActive() {
@@ -85,36 +135,91 @@ bool Bmp183Drv::isActive() {
 
 std::string Bmp183Drv::getValueByName(std::string name) {
     
-    for (int i = 0; i < numValues; i++) {
-        if (name == valueNames[i]) {
-            return this->getValueAtIndex(i);
-        }
+    int index = descriptor.find(sensor::StrRef(name.data(), name.size()));
+    
+    if (index < 0) {
+        return "none";
     }
     
-    return "none";
+    return this->getValueAtIndex(index);
 }
 
 std::string Bmp183Drv::getValueAtIndex(int index) {
+    int mode;
     
-    if (!this->active) {
+    return this->getValueAtIndex(index, mode);
+}
+
+/**
+ * Reads the value at index as a string, along with the mode of the sample it came from.
+ * @param mode set to the bmp183_mode_t of a pressure sample, or -1 for a temperature or invalid value
+ */
+std::string Bmp183Drv::getValueAtIndex(int index, int &mode) {
+    
+    float value = this->getFloatAtIndex(index, mode);
+    
+    // Invalid data is represented as NaN, and reported as none
+    if (std::isnan(value)) {
         return "none";
     }
+    
+    stats::ScopedTimer timer(this->driverStats.formatting);
+    
+    return DataManip::dataToString(value, 1);
+}
 
-    if (index == 0) {
-        return this->readValue0();
-    }
-    else if (index == 1) {
-        return this->readValue1();
+/**
+ * Reads the value at index through its typed reader in the sensor descriptor.
+ * @return the value, or NaN if the device is inactive, the index is invalid, or the data is invalid
+ */
+float Bmp183Drv::getFloatAtIndex(int index) {
+    int mode;
+    
+    return this->getFloatAtIndex(index, mode);
+}
+
+/**
+ * Reads the value at index, along with the mode of the sample it came from. Pressure is read
+ * directly rather than through the descriptor, so that the mode is that of its own sample rather
+ * than whichever the sampler converted last.
+ * @param mode set to the bmp183_mode_t of a pressure sample, or -1 for a temperature or invalid value
+ * @return the value, or NaN if the device is inactive, the index is invalid, or the data is invalid
+ */
+float Bmp183Drv::getFloatAtIndex(int index, int &mode) {
+    
+    mode = -1;
+    
+    if (!this->active || !descriptor.contains(index)) {
+        return NAN;
     }
-    else {
-        return "none";
+    
+    float value = (index == 0) ? this->readPressure(mode) : descriptor.read(*this, index);
+    
+    // Speculatively start the next conversion so the next request finds it ready
+    if ((this->readAhead > 0) && !this->sampling) {
+        this->requestPrefetch();
     }
     
+    return value;
+}
+
+/**
+ * Sets the initial altitude and operating mode -- default to ultra high if out of bounds
+ */
+void Bmp183Drv::configure(int altitude, int operationMode) {
+    this->config.update([&](bmp183_config &settings) {
+        settings.stationAltitude = altitude;
+        settings.operatingMode = BMP183_MODE_ULTRAHIGHRES;
+        
+        if ((operationMode >= BMP183_MODE_ULTRALOWPOWER) && (operationMode <= BMP183_MODE_ULTRAHIGHRES)) {
+            settings.operatingMode = operationMode;
+        }
+    });
 }
 
 bool Bmp183Drv::setOperatingMode(int operationMode) {
     if ((operationMode >= BMP183_MODE_ULTRALOWPOWER) && (operationMode <= BMP183_MODE_ULTRAHIGHRES)) {
-        this->operatingMode = (bmp183_mode_t)operationMode;
+        this->config.update([&](bmp183_config &settings) { settings.operatingMode = operationMode; });
         return true;
     }
     else {
@@ -122,90 +227,960 @@ bool Bmp183Drv::setOperatingMode(int operationMode) {
     }
 }
 
-bool Bmp183Drv::initialize() {
+bool Bmp183Drv::setLatencyBudget(int microseconds) {
+    // The budget must at least cover the fastest pressure conversion, or zero to disable
+    if ((microseconds == 0) || (microseconds >= pressureConversionTime[BMP183_MODE_ULTRALOWPOWER])) {
+        this->config.update([&](bmp183_config &settings) { settings.latencyBudget = microseconds; });
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+bool Bmp183Drv::setSampleRate(float hertz) {
+    if (std::isnan(hertz)) {
+        return false;
+    }
+    
+    if (hertz <= 0) {
+        return this->setLatencyBudget(0);
+    }
+    
+    // At 1 Hz or less every mode fits, and clamping keeps a tiny rate from overflowing the budget
+    if (hertz < 1) {
+        hertz = 1;
+    }
+    
+    return this->setLatencyBudget((int)(1000000 / hertz));
+}
+
+bool Bmp183Drv::setTemperatureReuse(int milliseconds) {
+    if (milliseconds >= 0) {
+        this->config.update([&](bmp183_config &settings) { settings.temperatureReuse = milliseconds; });
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+/**
+ * Sets the filter the compensated pressure of every sample passes through. The filter starts
+ * afresh from the next sample, without waiting for a conversion under way.
+ * @param filter a filter configured as IIR, Kalman or none
+ */
+void Bmp183Drv::setFilter(const SampleFilter &filter) {
+    this->config.update([&](bmp183_config &settings) {
+        settings.filter = filter;
+        settings.filterVersion++;
+    });
+}
+
+/**
+ * Sets the altitude that pressure is adjusted to sea level from, taking effect with the next
+ * value read, history record or export
+ * @param altitude station altitude in meters
+ */
+void Bmp183Drv::setStationAltitude(int altitude) {
+    this->config.update([&](bmp183_config &settings) { settings.stationAltitude = altitude; });
+}
+
+int Bmp183Drv::getStationAltitude() {
+    return this->config.load().stationAltitude;
+}
+
+int Bmp183Drv::getLastMode() {
+    return this->lastMode;
+}
+
+/**
+ * Starts a background sampling loop whose rate adapts to the rate of change and variance of
+ * the pressure. The loop samples at the ceiling rate while pressure moves, and backs off toward
+ * the floor rate while it is stable. Restarting an active loop just applies the new rates.
+ * @param floorHertz the slowest sampling rate
+ * @param ceilingHertz the fastest sampling rate
+ */
+bool Bmp183Drv::startSampling(float floorHertz, float ceilingHertz) {
+    if (!this->active) {
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->sampleMutex);
+        
+        if (!this->cadence.setRates(floorHertz, ceilingHertz)) {
+            return false;
+        }
+        
+        this->cadence.reset();
+        this->sampling = true;
+    }
+    
+    this->startWorker();
+    
+    return true;
+}
+
+void Bmp183Drv::stopSampling() {
+    {
+        std::lock_guard<std::mutex> lock(this->sampleMutex);
+        this->sampling = false;
+    }
+    
+    if (this->readAhead == 0) {
+        this->stopWorker();
+    }
+}
+
+/**
+ * Enables speculative read-ahead for on-demand reads. Each value returned starts the next
+ * conversion in the background, and a request arriving while that result is still fresh is
+ * served from it without waiting on a conversion.
+ * @param milliseconds the age beyond which a read-ahead sample is discarded, or 0 to disable
+ */
+bool Bmp183Drv::setReadAhead(int milliseconds) {
+    if (milliseconds < 0) {
+        return false;
+    }
+    
+    if (milliseconds > 0) {
+        if (!this->active) {
+            return false;
+        }
+        
+        this->readAhead = milliseconds;
+        this->startWorker();
+    }
+    else {
+        this->readAhead = 0;
+        if (!this->sampling) {
+            this->stopWorker();
+        }
+    }
+    
+    return true;
+}
+
+bool Bmp183Drv::isSampling() {
+    return this->sampling;
+}
+
+bool Bmp183Drv::setCadenceThresholds(float rateThreshold, float varianceThreshold) {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    return this->cadence.setThresholds(rateThreshold, varianceThreshold);
+}
+
+/**
+ * @return the current interval between background samples, in milliseconds
+ */
+int Bmp183Drv::getSampleInterval() {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    return this->cadence.getInterval() / 1000;
+}
+
+bool Bmp183Drv::getLatestSample(bmp183_sample &sample) {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    
+    if (this->sampleCount == 0) {
+        return false;
+    }
+    
+    sample = this->samples[(this->sampleCount - 1) % sampleBufferSize];
+    
+    return true;
+}
+
+/**
+ * @return the number of samples buffered since the driver was created, which numbers them for
+ * exportSamples
+ */
+uint64_t Bmp183Drv::getSampleCount() {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    return this->sampleCount;
+}
+
+/**
+ * Encodes buffered samples for telemetry, starting with sample number since, or the oldest still
+ * buffered if that has been overwritten. Pressure is adjusted to sea level. Samples are encoded
+ * straight from the buffer under the lock, which is held for a few hundred ns per sample.
+ * @param encoder the format and tags to encode with
+ * @param out where to write the encoded batch
+ * @param size the room at out, which limits the number of samples taken
+ * @param next set to the number of the first sample not taken, to pass as since on the next call
+ * @param count set to the number of samples taken
+ * @return the number of bytes written, 0 if there are no new samples
+ */
+size_t Bmp183Drv::exportSamples(TelemetryEncoder &encoder, uint64_t since, char *out, size_t size, uint64_t &next, size_t &count) {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    
+    int altitude = this->config.load().stationAltitude;
+    uint64_t oldest = (this->sampleCount > sampleBufferSize) ? this->sampleCount - sampleBufferSize : 0;
+    uint64_t index = (since > oldest) ? since : oldest;
+    size_t perSample = encoder.maxEncodedSize(1) - encoder.maxEncodedSize(0);
+    size_t length = 0;
+    
+    count = 0;
+    
+    if ((index < this->sampleCount) && (size >= encoder.maxEncodedSize(1))) {
+        length = encoder.begin(out);
+        
+        for (; (index < this->sampleCount) && (length + perSample <= size); index++) {
+            bmp183_sample sample = this->samples[index % sampleBufferSize];
+            sample.pressure = (int32_t)lroundf(seaLevelPressure(sample.pressure / 100.0F, altitude) * 100);
+            
+            length += encoder.encode(sample, out + length);
+            count++;
+        }
+    }
+    
+    next = index;
+    
+    return length;
+}
+
+/**
+ * Returns an eventfd which becomes readable when background sampling or read-ahead buffers new
+ * samples, for applications with their own poll or epoll loop. It is signalled once until the
+ * samples are drained, so a busy sampler wakes the consumer once for many samples. The driver
+ * owns the descriptor and closes it when destroyed.
+ * @return the descriptor, or -1 if it could not be created
+ */
+int Bmp183Drv::getSampleEventFd() {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    
+    if (this->sampleEventFd < 0) {
+        this->sampleEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        
+        if (this->sampleEventFd < 0) {
+            std::cerr << descriptor.name.data() << " sample eventfd could not be created: " << strerror(errno) << std::endl;
+            return -1;
+        }
+        
+        this->sampleEventSignalled = false;
+        
+        // Samples buffered before the descriptor existed are waiting too
+        if (this->sampleCount > 0) {
+            this->signalSamples();
+        }
+    }
+    
+    return this->sampleEventFd;
+}
+
+/**
+ * Copies buffered samples, starting with sample number since, or the oldest still buffered if
+ * that has been overwritten, and rearms the sample eventfd. If samples are left over, the
+ * eventfd is signalled again at once.
+ * @param samples where to copy the samples
+ * @param count the most samples to copy
+ * @param next set to the number of the first sample not copied, to pass as since on the next call
+ * @return the number of samples copied
+ */
+size_t Bmp183Drv::drainSamples(uint64_t since, bmp183_sample *samples, size_t count, uint64_t &next) {
+    std::lock_guard<std::mutex> lock(this->sampleMutex);
+    
+    if (this->sampleEventFd >= 0) {
+        eventfd_t value;
+        
+        // Nonblocking, so this only clears a pending signal
+        eventfd_read(this->sampleEventFd, &value);
+        this->sampleEventSignalled = false;
+    }
+    
+    uint64_t oldest = (this->sampleCount > sampleBufferSize) ? this->sampleCount - sampleBufferSize : 0;
+    uint64_t index = (since > oldest) ? since : oldest;
+    size_t copied = 0;
+    
+    for (; (index < this->sampleCount) && (copied < count); index++) {
+        samples[copied++] = this->samples[index % sampleBufferSize];
+    }
+    
+    next = index;
+    
+    if ((index < this->sampleCount) && (this->sampleEventFd >= 0)) {
+        this->signalSamples();
+    }
+    
+    return copied;
+}
+
+// Wakes a consumer polling the sample eventfd -- called with sampleMutex held
+void Bmp183Drv::signalSamples() {
+    if (this->sampleEventFd < 0) {
+        return;
+    }
+    
+    if (eventfd_write(this->sampleEventFd, 1) == 0) {
+        this->sampleEventSignalled = true;
+    }
+}
+
+/**
+ * Converts a whole sample now, with raw and compensated values, bypassing any sampled or
+ * read-ahead result. Pressure is the station pressure, not adjusted to sea level.
+ * @param sample the sample to fill in
+ * @return false if the device is inactive or could not be read
+ */
+bool Bmp183Drv::readSample(bmp183_sample &sample) {
+    if (!this->active) {
+        return false;
+    }
+    
+    return this->acquireSample(sample);
+}
+
+/**
+ * Returns a sample that is already available without a new conversion: the latest sample while
+ * sampling, or a fresh read-ahead sample, waiting for one that is already under way.
+ * @param sample the sample to fill in
+ * @return false if the caller must convert a new sample itself
+ */
+bool Bmp183Drv::getReadySample(bmp183_sample &sample) {
+    if (this->sampling) {
+        return this->getLatestSample(sample);
+    }
+    
+    if (this->readAhead == 0) {
+        return false;
+    }
+    
+    std::unique_lock<std::mutex> lock(this->sampleMutex);
+    
+    // A conversion under way finishes sooner than a new one would
+    if (!this->sampleIsFresh()) {
+        this->sampleReady.wait(lock, [this] { return !this->prefetchPending && !this->prefetchInFlight; });
+    }
+    
+    if (!this->sampleIsFresh()) {
+        return false;
+    }
+    
+    sample = this->samples[(this->sampleCount - 1) % sampleBufferSize];
+    
+    return true;
+}
+
+bool Bmp183Drv::sampleIsFresh() {
+    if (this->sampleCount == 0) {
+        return false;
+    }
+    
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t age = now - this->samples[(this->sampleCount - 1) % sampleBufferSize].timestamp;
+    
+    return (age < (int64_t)this->readAhead * 1000);
+}
+
+void Bmp183Drv::requestPrefetch() {
+    {
+        std::lock_guard<std::mutex> lock(this->sampleMutex);
+        
+        if (this->prefetchPending || this->prefetchInFlight) {
+            return;
+        }
+        
+        this->prefetchPending = true;
+    }
+    
+    this->samplerSignal.notify_all();
+}
+
+void Bmp183Drv::startWorker() {
+    if (!this->running.exchange(true)) {
+        this->worker = std::thread(&Bmp183Drv::samplingLoop, this);
+    }
+    else {
+        this->samplerSignal.notify_all();
+    }
+}
+
+void Bmp183Drv::stopWorker() {
+    {
+        std::lock_guard<std::mutex> lock(this->sampleMutex);
+        this->running = false;
+    }
+    
+    this->samplerSignal.notify_all();
+    
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+    
+    // Release anyone still waiting on a read-ahead that will never come
+    {
+        std::lock_guard<std::mutex> lock(this->sampleMutex);
+        this->prefetchPending = false;
+    }
+    
+    this->sampleReady.notify_all();
+}
+
+/**
+ * Body of the worker thread. Samples continuously at the adaptive cadence while sampling, and
+ * otherwise converts one read-ahead sample each time one is requested.
+ */
+void Bmp183Drv::samplingLoop() {
+    std::unique_lock<std::mutex> lock(this->sampleMutex);
+    
+    trace::setThreadName("bmp183 sampler");
+    
+    while (this->running) {
+        if (!this->sampling && !this->prefetchPending) {
+            this->samplerSignal.wait(lock);
+            continue;
+        }
+        
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bmp183_sample sample;
+        
+        this->prefetchPending = false;
+        this->prefetchInFlight = true;
+        
+        lock.unlock();
+        bool acquired = this->acquireSample(sample);
+        lock.lock();
+        
+        this->prefetchInFlight = false;
+        
+        if (acquired) {
+            this->samples[this->sampleCount % sampleBufferSize] = sample;
+            this->sampleCount++;
+            
+            if (!this->sampleEventSignalled) {
+                this->signalSamples();
+            }
+            
+            if (this->sampling) {
+                // The filter's lag would hold back the detection of a front, which is what the cadence is for
+                this->cadence.update(sample.unfilteredPressure / 100.0F, sample.timestamp);
+            }
+        }
+        
+        this->sampleReady.notify_all();
+        
+        if (this->sampling) {
+            std::chrono::microseconds interval(this->cadence.getInterval());
+            this->samplerSignal.wait_until(lock, start + interval, [this] { return !this->running || !this->sampling; });
+        }
+    }
+}
+
+/**
+ * Starts appending the raw words of every sample taken, by any path, to a capture file
+ * which Bmp183Replay can later feed back through compensation.
+ * @param filename the capture to create, or to append to if it came from this device
+ * @return false if the device is inactive or the file could not be opened
+ */
+bool Bmp183Drv::startRecording(std::string filename) {
+    if (!this->active) {
+        return false;
+    }
+    
+    Bmp183Recorder *newRecorder = new Bmp183Recorder();
+    
+    if (!newRecorder->open(filename, this->bmp183_coeffs)) {
+        delete newRecorder;
+        return false;
+    }
+    
+    Bmp183Recorder *oldRecorder;
+    {
+        std::lock_guard<std::mutex> lock(this->recorderMutex);
+        oldRecorder = this->recorder;
+        this->recorder = newRecorder;
+    }
+    delete oldRecorder;
+    
+    return true;
+}
+
+void Bmp183Drv::stopRecording() {
+    Bmp183Recorder *oldRecorder;
+    {
+        std::lock_guard<std::mutex> lock(this->recorderMutex);
+        oldRecorder = this->recorder;
+        this->recorder = 0;
+    }
+    delete oldRecorder;
+}
+
+bool Bmp183Drv::isRecording() {
+    std::lock_guard<std::mutex> lock(this->recorderMutex);
+    return (this->recorder != 0);
+}
+
+const bmp183_calib_data& Bmp183Drv::getCalibration() {
+    return this->bmp183_coeffs;
+}
+
+/**
+ * Starts keeping every sample taken, and its 1 s, 1 min and 1 h aggregates, in ring files
+ * which persist across restarts. Pressure is kept adjusted to sea level, as it is reported.
+ * @param directory where the ring files live, created if needed
+ * @return false if the store could not be opened
+ */
+bool Bmp183Drv::openHistory(std::string directory) {
+    HistoryStore *store = new HistoryStore();
+    
+    if (!store->open(directory)) {
+        delete store;
+        return false;
+    }
+    
+    HistoryStore *oldStore;
+    {
+        std::lock_guard<std::mutex> lock(this->historyMutex);
+        oldStore = this->history;
+        this->history = store;
+    }
+    delete oldStore;
+    
+    return true;
+}
+
+void Bmp183Drv::closeHistory() {
+    HistoryStore *oldStore;
+    {
+        std::lock_guard<std::mutex> lock(this->historyMutex);
+        oldStore = this->history;
+        this->history = 0;
+    }
+    delete oldStore;
+}
+
+/**
+ * @return the open history store, or null. It stays valid until closeHistory is called.
+ */
+HistoryStore* Bmp183Drv::getHistory() {
+    std::lock_guard<std::mutex> lock(this->historyMutex);
+    return this->history;
+}
+
+/**
+ * Finds the fastest SPI clock that reads the device reliably. The calibration block is read at
+ * the slowest rate as a reference, then the clock is stepped up, and each step must read the
+ * chip ID and a calibration block identical to the reference repeatedly without a failed
+ * transfer. The clock settles on the last step to pass, and afterwards is stepped back down
+ * whenever a sample shows read errors.
+ * @param maxSpeed the fastest clock to try, in Hz
+ * @return the clock chosen, in Hz, or 0 if not even the slowest rate is reliable
+ */
+uint32_t Bmp183Drv::tuneSpeed(uint32_t maxSpeed) {
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    
+    if (!this->active) {
+        return 0;
+    }
+    
+    if (this->device->getType() != bus::BusDevice::SPI) {
+        std::cerr << descriptor.name.data() << " clock is set by the bus adapter, and can't be tuned" << std::endl;
+        return 0;
+    }
+    
+    uint32_t original = this->device->getSpeed();
+    bmp183_calib_data reference;
     
-    setSpeed(5000000);
-    setMode(spibus::SPIDevice::MODE3);
+    this->device->setSpeed(busSpeeds[0]);
+    this->readCoefficients(reference);
     
-    // Mode boundary check -- default to ultra high if out of bounds
-    if ((this->operatingMode > BMP183_MODE_ULTRAHIGHRES) || (this->operatingMode < 0)) {
-        this->operatingMode = BMP183_MODE_ULTRAHIGHRES;
+    if (!calibrationIsValid(reference) || !this->verifySpeed(busSpeeds[0], reference)) {
+        std::cerr << descriptor.name.data() << " can't be read reliably at " << busSpeeds[0] << " Hz, clock left at " << original << " Hz" << std::endl;
+        this->device->setSpeed(original);
+        return 0;
+    }
+    
+    int step = 0;
+    
+    while ((step + 1 < numBusSpeeds) && (busSpeeds[step + 1] <= maxSpeed) && this->verifySpeed(busSpeeds[step + 1], reference)) {
+        step++;
+    }
+    
+    this->device->setSpeed(busSpeeds[step]);
+    this->busSpeedStep = step;
+    
+    // The reference was read at the slowest rate, so trust it over the block read at startup
+    this->bmp183_coeffs = reference;
+    
+    DPRINT(descriptor.name.data() << " SPI clock tuned to " << busSpeeds[step] << " Hz");
+    
+    return busSpeeds[step];
+}
+
+bool Bmp183Drv::verifySpeed(uint32_t speed, const bmp183_calib_data &reference) {
+    uint64_t failures = this->device->getBusStats().failures.load(std::memory_order_relaxed);
+    
+    if (this->device->setSpeed(speed) < 0) {
+        return false;
+    }
+    
+    for (int i = 0; i < busSpeedVerifyReads; i++) {
+        bmp183_calib_data coeffs;
+        
+        if ((uint8_t)this->device->readRegister(BMP183_REGISTER_CHIPID) != 0x55) {
+            return false;
+        }
+        
+        this->readCoefficients(coeffs);
+        
+        if (memcmp(&coeffs, &reference, sizeof coeffs) != 0) {
+            return false;
+        }
+    }
+    
+    return (this->device->getBusStats().failures.load(std::memory_order_relaxed) == failures);
+}
+
+/**
+ * Steps a tuned clock down after read errors. Called with busMutex held.
+ */
+void Bmp183Drv::backOffSpeed() {
+    if (this->busSpeedStep > 0) {
+        this->busSpeedStep--;
+        this->device->setSpeed(busSpeeds[this->busSpeedStep]);
+        std::cerr << descriptor.name.data() << " read errors, SPI clock backed off to " << busSpeeds[this->busSpeedStep] << " Hz" << std::endl;
+    }
+}
+
+uint32_t Bmp183Drv::getBusSpeed() {
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    return this->device->getSpeed();
+}
+
+bus::BusStats& Bmp183Drv::getBusStats() {
+    return this->device->getBusStats();
+}
+
+Bmp183Stats& Bmp183Drv::getStats() {
+    return this->driverStats;
+}
+
+void Bmp183Drv::resetStats() {
+    this->driverStats.reset();
+    this->device->getBusStats().reset();
+}
+
+bool Bmp183Drv::initialize() {
+    
+    // The BMP085 and BMP180 sit on I2C, where the adapter sets the clock and the control
+    // register is written at its full address
+    if (this->device->getType() == bus::BusDevice::SPI) {
+        this->device->setSpeed(5000000);
+        static_cast<spibus::SPIDevice *>(this->device)->setMode(spibus::SPIDevice::MODE3);
+        this->controlRegister = BMP183_REGISTER_CONTROL;
+    }
+    else {
+        this->controlRegister = BMP183_REGISTER_CONTROL_I2C;
     }
     
     // Make sure we have the right device
-    uint8_t id = (uint8_t)readRegister(BMP183_REGISTER_CHIPID);
+    uint8_t id = (uint8_t)this->device->readRegister(BMP183_REGISTER_CHIPID);
     
     if (id != 0x55) {
         return false;
     }
     
-    readCoefficients();
+    readCoefficients(this->bmp183_coeffs);
     
     getPressure();
 
     return true;
 }
 
-std::string Bmp183Drv::readValue0() {
+float Bmp183Drv::readValue0() {
+    int mode;
+    
+    return this->readPressure(mode);
+}
+
+/**
+ * Reads the sea level pressure, from a ready sample if there is one, or else a new conversion
+ * @param mode set to the bmp183_mode_t of the sample, or -1 if the value is invalid
+ */
+float Bmp183Drv::readPressure(int &mode) {
+    
+    mode = -1;
     
     if (!this->active) {
-        return "none";
+        return NAN;
+    }
+    
+    bmp183_sample sample;
+    
+    // Serve a sample from the sampler or read-ahead when one is ready, rather than converting again
+    if (!this->getReadySample(sample) && !this->acquireSample(sample)) {
+        return NAN;
+    }
+    
+    float pressure = sample.pressure / 100.0F;
+    
+    if (pressure <= 0) {
+        return NAN;
     }
     
     // Get the pressure adjusted for altitude
-    float value = this->seaLevelPressure(this->getPressure(), this->stationAltitude);
+    float value = seaLevelPressure(pressure, this->getStationAltitude());
     
-    // If the data is not valid, just return none
+    // If the data is not valid, just return NaN
     if ((value < 850) || (value > 1090)) {
-        return "none";
+        return NAN;
     }
     
-    return DataManip::dataToString(value, 1);
+    mode = sample.mode;
+    
+    return value;
 }
 
 
-std::string Bmp183Drv::readValue1() {
+float Bmp183Drv::readValue1() {
     
     if (!this->active) {
-        return "none";
+        return NAN;
     }
     
-    float value = this->getTemperature();
+    bmp183_sample sample;
+    float value;
+    
+    if (this->getReadySample(sample)) {
+        value = sample.temperature / 100.0F;
+    }
+    else {
+        value = this->getTemperature();
+    }
     
-    // If the data is not valid, just return none
+    // If the data is not valid, just return NaN
     if ((value < -50) || (value > 55)) {
-        return "none";
+        return NAN;
     }
     
-    return DataManip::dataToString(value, 1);
+    return value;
 }
 
 
 float Bmp183Drv::getPressure(void) {
-    int32_t  ut = 0, up = 0, compp = 0;
+    bmp183_sample sample;
+    
+    if (!this->acquireSample(sample)) {
+        return 0;
+    }
+    
+    /* Assign compensated pressure value */
+    return sample.pressure / 100.0F;
+}
+
+/**
+ * Runs one temperature and pressure conversion and fills in the raw and compensated values.
+ * Conversions are serialized, so this is safe to call from the sampler and on-demand reads at once.
+ * @param sample the sample to fill in
+ * @return false if the device is not open or the sample read back corrupt
+ */
+bool Bmp183Drv::acquireSample(bmp183_sample &sample) {
+    Bmp183Conversion conversion;
+    int wait = this->startConversion(conversion);
+    
+    while (wait > 0) {
+        {
+            stats::ScopedTimer timer(this->driverStats.conversionWait);
+            trace::ScopedSpan span("conversion wait", "conversion", "nominal_us", wait);
+            usleep(wait);
+        }
+        
+        wait = this->continueConversion(conversion);
+    }
+    
+    if (wait < 0) {
+        return false;
+    }
+    
+    sample = conversion.sample;
+    
+    return true;
+}
+
+/**
+ * Starts converting a sample without waiting on it, so that a caller such as Bmp183Array can
+ * have several sensors converting at once. The bus stays locked until the sample is complete,
+ * or the conversion is destroyed.
+ * @param conversion the state of the sample, to pass to continueConversion
+ * @return microseconds to wait before calling continueConversion, or -1 if the device is not open
+ */
+int Bmp183Drv::startConversion(Bmp183Conversion &conversion) {
+    {
+        trace::ScopedSpan span("bus lock wait", "conversion");
+        conversion.lock = std::unique_lock<std::mutex>(this->busMutex);
+    }
+    
+    if (!this->device->isOpen()) {
+        conversion.lock.unlock();
+        return -1;
+    }
+    
+    conversion.start = std::chrono::steady_clock::now();
+    conversion.failures = this->device->getBusStats().failures.load(std::memory_order_relaxed);
+    
+    /* Take the settings once so that every step of this sample agrees on them */
+    conversion.settings = this->config.load();
+    conversion.temperatureNeeded = !this->temperatureIsFresh(conversion.settings);
+    conversion.pressureStarted = false;
+    conversion.sample.mode = this->selectMode(conversion.settings, conversion.temperatureNeeded);
+    
+    if (conversion.temperatureNeeded) {
+        this->startTemperatureConversion();
+        return temperatureConversionTime;
+    }
+    
+    conversion.sample.rawTemperature = this->lastRawTemperature;
+    this->startPressureConversion((bmp183_mode_t)conversion.sample.mode);
+    conversion.pressureStarted = true;
+    
+    return pressureConversionTime[conversion.sample.mode];
+}
+
+/**
+ * Reads the conversion under way and starts the next, or completes the sample once the pressure
+ * is in, with the compensated and filtered values, recording and history.
+ * @param conversion the state of the sample, from startConversion
+ * @return microseconds to wait before calling again, 0 once the sample is complete, or -1 if the
+ * conversion was not started or the sample read back corrupt
+ */
+int Bmp183Drv::continueConversion(Bmp183Conversion &conversion) {
+    if (!conversion.lock.owns_lock()) {
+        return -1;
+    }
+    
+    bmp183_sample &sample = conversion.sample;
+    bmp183_mode_t mode = (bmp183_mode_t)sample.mode;
+    const bmp183_config &settings = conversion.settings;
+    
+    if (!conversion.pressureStarted) {
+        sample.rawTemperature = this->readTemperatureConversion();
+        this->startPressureConversion(mode);
+        conversion.pressureStarted = true;
+        
+        return pressureConversionTime[mode];
+    }
+    
+    sample.rawPressure = this->readPressureConversion(mode);
+    sample.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    /* Track how far the real read time runs past the nominal conversion time */
+    if (settings.latencyBudget > 0) {
+        int elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - conversion.start).count();
+        int nominal = pressureConversionTime[mode] + (conversion.temperatureNeeded ? temperatureConversionTime : 0);
+        this->conversionOverhead += ((elapsed - nominal) - this->conversionOverhead) / 8;
+    }
+    
+    /* A failed transfer, or a data word stuck at all zeros or all ones, corrupts the sample */
+    if ((this->device->getBusStats().failures.load(std::memory_order_relaxed) != conversion.failures) ||
+        (sample.rawTemperature == 0) || ((uint16_t)sample.rawTemperature == 0xFFFF) ||
+        (sample.rawPressure == 0) || ((uint32_t)sample.rawPressure == (0xFFFFFFu >> (8 - mode)))) {
+        
+        // The cached temperature may be the bad word, so the next sample converts it afresh
+        this->lastTemperatureTime = std::chrono::steady_clock::now() - std::chrono::milliseconds(settings.temperatureReuse);
+        
+        // On a tuned clock, errors mean the clock is too fast
+        if (this->busSpeedStep >= 0) {
+            this->backOffSpeed();
+        }
+        
+        if (stats::isEnabled()) {
+            this->driverStats.corrupt.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        conversion.lock.unlock();
+        
+        return -1;
+    }
+    
+    this->lastMode = mode;
+    
+    {
+        stats::ScopedTimer timer(this->driverStats.compensation);
+        trace::ScopedSpan span("compensate", "conversion");
+        compensate(this->bmp183_coeffs, sample);
+        
+        if (settings.filterVersion != this->filterVersion) {
+            this->pressureFilter = settings.filter;
+            this->pressureFilter.reset();
+            this->filterVersion = settings.filterVersion;
+        }
+        filter(this->pressureFilter, sample);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->recorderMutex);
+        if (this->recorder != 0) {
+            this->recorder->record(sample);
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->historyMutex);
+        if (this->history != 0) {
+            float seaLevel = seaLevelPressure(sample.pressure / 100.0F, settings.stationAltitude);
+            
+            // Keep the history to the same valid range as the values reported
+            if ((seaLevel >= 850) && (seaLevel <= 1090)) {
+                this->history->insert(sample.timestamp, seaLevel, sample.temperature / 100.0F);
+            }
+        }
+    }
+    
+    if (stats::isEnabled()) {
+        this->driverStats.samples.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    if (trace::isEnabled()) {
+        trace::record("sample", "conversion", conversion.start, std::chrono::steady_clock::now(), "mode", mode);
+    }
+    
+    conversion.lock.unlock();
+    
+    return 0;
+}
+
+/**
+ * Passes the compensated pressure of a sample through a filter, which for a Kalman filter
+ * takes the measurement noise of the mode the sample was converted in. Temperature is left
+ * unfiltered, as it feeds the compensation of later samples.
+ * @param filter the filter, holding the state of the series the sample belongs to
+ * @param sample the compensated sample, whose pressure is replaced by the filtered value, leaving
+ * unfilteredPressure as compensated
+ */
+void Bmp183Drv::filter(SampleFilter &filter, bmp183_sample &sample) {
+    float noise = pressureNoise[(sample.mode < numModes) ? sample.mode : BMP183_MODE_ULTRALOWPOWER];
+    sample.pressure = (int32_t)lroundf(filter.update(sample.pressure, sample.timestamp, noise * noise));
+}
+
+/**
+ * Applies the datasheet compensation to the raw values of a sample, using the mode the raw
+ * pressure was converted in.
+ * @param coeffs the calibration data of the device the sample came from
+ * @param sample the sample with raw values, mode set, and compensated values to be filled in
+ */
+void Bmp183Drv::compensate(const bmp183_calib_data &coeffs, bmp183_sample &sample) {
+    int32_t  ut = sample.rawTemperature, up = sample.rawPressure, compp = 0;
     int32_t  x1, x2, b5, b6, x3, b3, p;
     uint32_t b4, b7;
-    
-    /* Get the raw pressure and temperature values */
-    ut = readRawTemperature();
-    up = readRawPressure();
+    int mode = sample.mode;
     
     /* Temperature compensation */
-    x1 = (ut - (int32_t)(this->bmp183_coeffs.ac6))*((int32_t)(this->bmp183_coeffs.ac5))/pow(2,15);
-    x2 = ((int32_t)(this->bmp183_coeffs.mc*pow(2,11)))/(x1+(int32_t)(this->bmp183_coeffs.md));
+    x1 = (ut - (int32_t)(coeffs.ac6))*((int32_t)(coeffs.ac5))/pow(2,15);
+    x2 = ((int32_t)(coeffs.mc*pow(2,11)))/(x1+(int32_t)(coeffs.md));
     b5 = x1 + x2;
+    sample.temperature = ((b5 + 8) * 10) / 16;
     
     /* Pressure compensation */
     b6 = b5 - 4000;
-    x1 = (this->bmp183_coeffs.b2 * ((b6 * b6) >> 12)) >> 11;
-    x2 = (this->bmp183_coeffs.ac2 * b6) >> 11;
+    x1 = (coeffs.b2 * ((b6 * b6) >> 12)) >> 11;
+    x2 = (coeffs.ac2 * b6) >> 11;
     x3 = x1 + x2;
-    b3 = (((((int32_t) this->bmp183_coeffs.ac1) * 4 + x3) << this->operatingMode) + 2) >> 2;
-    x1 = (this->bmp183_coeffs.ac3 * b6) >> 13;
-    x2 = (this->bmp183_coeffs.b1 * ((b6 * b6) >> 12)) >> 16;
+    b3 = (((((int32_t) coeffs.ac1) * 4 + x3) << mode) + 2) >> 2;
+    x1 = (coeffs.ac3 * b6) >> 13;
+    x2 = (coeffs.b1 * ((b6 * b6) >> 12)) >> 16;
     x3 = ((x1 + x2) + 2) >> 2;
-    b4 = (this->bmp183_coeffs.ac4 * (uint32_t) (x3 + 32768)) >> 15;
-    b7 = ((uint32_t) (up - b3) * (50000 >> this->operatingMode));
+    b4 = (coeffs.ac4 * (uint32_t) (x3 + 32768)) >> 15;
+    b7 = ((uint32_t) (up - b3) * (50000 >> mode));
     
     if (b7 < 0x80000000) {
         p = (b7 << 1) / b4;
@@ -219,15 +1194,18 @@ float Bmp183Drv::getPressure(void) {
     x2 = (-7357 * p) >> 16;
     compp = p + ((x1 + x2 + 3791) >> 4);
     
-    /* Assign compensated pressure value */
-    return compp / 100.0F;
+    sample.pressure = compp;
+    sample.unfilteredPressure = compp;
 }
 
 float Bmp183Drv::getTemperature(void) {
     int32_t UT, X1, X2, B5;     // following ds convention
     float t;
     
-    UT = readRawTemperature();
+    {
+        std::lock_guard<std::mutex> lock(this->busMutex);
+        UT = readRawTemperature();
+    }
     
     // step 1
     X1 = (UT - (int32_t)this->bmp183_coeffs.ac6) * ((int32_t)this->bmp183_coeffs.ac5) / pow(2,15);
@@ -273,68 +1251,119 @@ float Bmp183Drv::seaLevelPressure(float pressure_mb, int stationAltitude) {
 }
 
 
-void Bmp183Drv::readCoefficients(void) {
-    this->bmp183_coeffs.ac1 = this->readSigned16(BMP183_REGISTER_CAL_AC1);
-    this->bmp183_coeffs.ac2 = this->readSigned16(BMP183_REGISTER_CAL_AC2);
-    this->bmp183_coeffs.ac3 = this->readSigned16(BMP183_REGISTER_CAL_AC3);
-    this->bmp183_coeffs.ac4 = this->readSigned16(BMP183_REGISTER_CAL_AC4);
-    this->bmp183_coeffs.ac5 = this->readSigned16(BMP183_REGISTER_CAL_AC5);
-    this->bmp183_coeffs.ac6 = this->readSigned16(BMP183_REGISTER_CAL_AC6);
-    this->bmp183_coeffs.b1 = this->readSigned16(BMP183_REGISTER_CAL_B1);
-    this->bmp183_coeffs.b2 = this->readSigned16(BMP183_REGISTER_CAL_B2);
-    this->bmp183_coeffs.mb = this->readSigned16(BMP183_REGISTER_CAL_MB);
-    this->bmp183_coeffs.mc = this->readSigned16(BMP183_REGISTER_CAL_MC);
-    this->bmp183_coeffs.md = this->readSigned16(BMP183_REGISTER_CAL_MD);
+/**
+ * Chooses the highest resolution mode whose conversion fits within the latency budget, given
+ * the overhead observed on recent reads. The configured operating mode acts as a ceiling.
+ * @param temperatureNeeded true if a temperature conversion must precede the pressure conversion
+ */
+bmp183_mode_t Bmp183Drv::selectMode(const bmp183_config &settings, bool temperatureNeeded) {
+    if (settings.latencyBudget == 0) {
+        return (bmp183_mode_t)settings.operatingMode;
+    }
+    
+    int fixedCost = (this->conversionOverhead > 0) ? this->conversionOverhead : 0;
+    if (temperatureNeeded) {
+        fixedCost += temperatureConversionTime;
+    }
+    
+    for (int mode = settings.operatingMode; mode > BMP183_MODE_ULTRALOWPOWER; mode--) {
+        if (fixedCost + pressureConversionTime[mode] <= settings.latencyBudget) {
+            return (bmp183_mode_t)mode;
+        }
+    }
+    
+    return BMP183_MODE_ULTRALOWPOWER;
+}
+
+bool Bmp183Drv::temperatureIsFresh(const bmp183_config &settings) {
+    if (settings.temperatureReuse == 0) {
+        return false;
+    }
+    
+    std::chrono::steady_clock::duration age = std::chrono::steady_clock::now() - this->lastTemperatureTime;
+    
+    return (age < std::chrono::milliseconds(settings.temperatureReuse));
+}
+
+void Bmp183Drv::readCoefficients(bmp183_calib_data &coeffs) {
+    unsigned char block[22];
+    int16_t *words = (int16_t *)&coeffs;
+    
+    // The eleven words are consecutive from AC1 to MD, so the block is read in one transfer
+    if (this->device->readBlock(BMP183_REGISTER_CAL_AC1, block, sizeof block) < 0) {
+        memset(&coeffs, 0, sizeof coeffs);
+        return;
+    }
+    
+    for (int i = 0; i < 11; i++) {
+        words[i] = (int16_t)combineRegisters(block[2 * i], block[2 * i + 1]);
+    }
+}
+
+/**
+ * The datasheet guarantees no calibration word is 0 or 0xFFFF, which is what a disconnected
+ * or badly clocked bus tends to read.
+ */
+bool Bmp183Drv::calibrationIsValid(const bmp183_calib_data &coeffs) {
+    const uint16_t *words = (const uint16_t *)&coeffs;
+    
+    for (size_t i = 0; i < sizeof(coeffs) / sizeof(uint16_t); i++) {
+        if ((words[i] == 0x0000) || (words[i] == 0xFFFF)) {
+            return false;
+        }
+    }
+    
+    return true;
 }
 
 int16_t Bmp183Drv::readRawTemperature() {
-    writeRegister(BMP183_REGISTER_CONTROL, BMP183_REGISTER_READTEMPCMD);
-    usleep(5000);
-    return  this->readUnsigned16(BMP183_REGISTER_TEMPDATA);
+    this->startTemperatureConversion();
+    {
+        stats::ScopedTimer timer(this->driverStats.conversionWait);
+        trace::ScopedSpan span("conversion wait", "conversion", "nominal_us", temperatureConversionTime);
+        usleep(temperatureConversionTime);
+    }
+    
+    return this->readTemperatureConversion();
+}
+
+void Bmp183Drv::startTemperatureConversion() {
+    this->device->writeRegister(this->controlRegister, BMP183_REGISTER_READTEMPCMD);
+}
+
+int16_t Bmp183Drv::readTemperatureConversion() {
+    this->lastRawTemperature = this->readUnsigned16(BMP183_REGISTER_TEMPDATA);
+    this->lastTemperatureTime = std::chrono::steady_clock::now();
+    
+    return this->lastRawTemperature;
+}
+
+void Bmp183Drv::startPressureConversion(bmp183_mode_t mode) {
+    this->device->writeRegister(this->controlRegister, BMP183_REGISTER_READPRESSURECMD + (mode << 6));
 }
 
-int32_t Bmp183Drv::readRawPressure() {
+int32_t Bmp183Drv::readPressureConversion(bmp183_mode_t mode) {
     uint8_t  p8;
     uint16_t p16;
     int32_t  p32;
     
-    writeRegister(BMP183_REGISTER_CONTROL, BMP183_REGISTER_READPRESSURECMD + (this->operatingMode << 6));
-    
-    switch(this->operatingMode) {
-        case BMP183_MODE_ULTRALOWPOWER:
-            usleep(5000);
-            break;
-        case BMP183_MODE_STANDARD:
-            usleep(8000);
-            break;
-        case BMP183_MODE_HIGHRES:
-            usleep(14000);
-            break;
-        case BMP183_MODE_ULTRAHIGHRES:
-        default:
-            usleep(26000);
-            break;
-    }
-    
-    p16 = this->readUnsigned16(BMP183_REGISTER_PRESSUREDATA);
+    // MSB, LSB and XLSB in one transfer
+    unsigned char block[3] = { 0, 0, 0 };
+    this->device->readBlock(BMP183_REGISTER_PRESSUREDATA, block, sizeof block);
+    
+    p16 = combineRegisters(block[0], block[1]);
     p32 = (uint32_t)p16 << 8;
-    p8 = readRegister(BMP183_REGISTER_PRESSUREDATA+2);
+    p8 = block[2];
     p32 += p8;
-    p32 >>= (8 - this->operatingMode);
+    p32 >>= (8 - mode);
     
     return p32;
 }
 
 uint16_t Bmp183Drv::readUnsigned16(uint32_t registerAddress) {
-    uint16_t result;
-    result = combineRegisters(readRegister(registerAddress), readRegister(registerAddress+1));
-    return result;
-}
-
-int16_t Bmp183Drv::readSigned16(uint32_t registerAddress) {
-    int16_t result;
-    result = (int16_t)combineRegisters(readRegister(registerAddress), readRegister(registerAddress+1));
-    return result;
+    unsigned char block[2] = { 0, 0 };
+    this->device->readBlock(registerAddress, block, sizeof block);
+    return combineRegisters(block[0], block[1]);
 }
 
 /**
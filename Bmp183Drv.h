@@ -21,8 +21,23 @@
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 #include "SPIDevice.h"
 #include "DataManip.h"
+#include "SampleCadence.h"
+#include "SampleFilter.h"
+#include "SeqLock.h"
+#include "SensorDescriptor.h"
+
+class Bmp183Recorder;
+class HistoryStore;
+class TelemetryEncoder;
 
 #ifdef DEBUG
 #  define DPRINT(x) do { std::cerr << x; std::cerr << std::endl; } while (0)
@@ -31,16 +46,8 @@
 #endif
 
 
-static const std::string name = "BMP183";
-static const std::string type = "sensor";
-
-static const std::string version = "0.8.0";
-
 static const int numValues = 2;
 
-static const std::string valueNames[numValues] = {"pressure", "temperature"};
-static const std::string valueTypes[numValues] = {"float", "float"};
-
 /*=========================================================================
  REGISTERS
  -----------------------------------------------------------------------*/
@@ -61,7 +68,8 @@ enum
     BMP183_REGISTER_CHIPID             = 0xD0,
     BMP183_REGISTER_VERSION            = 0xD1,
     BMP183_REGISTER_SOFTRESET          = 0xE0,
-    BMP183_REGISTER_CONTROL            = 0x74,
+    BMP183_REGISTER_CONTROL            = 0x74,  // W   Control, written over SPI with bit 7 clear
+    BMP183_REGISTER_CONTROL_I2C        = 0xF4,  // W   Control at its full address, as on the BMP085 and BMP180
     BMP183_REGISTER_TEMPDATA           = 0xF6,
     BMP183_REGISTER_PRESSUREDATA       = 0xF6,
     BMP183_REGISTER_READTEMPCMD        = 0x2E,
@@ -80,6 +88,26 @@ typedef enum
     BMP183_MODE_HIGHRES                = 2,
     BMP183_MODE_ULTRAHIGHRES           = 3
 } bmp183_mode_t;
+
+static const int numModes = 4;
+
+// Maximum conversion times in microseconds, per the datasheet
+static const int temperatureConversionTime = 5000;
+static const int pressureConversionTime[numModes] = {5000, 8000, 14000, 26000};
+
+// Typical RMS pressure noise in Pa, per the datasheet
+static const float pressureNoise[numModes] = {6, 5, 4, 3};
+/*=========================================================================*/
+
+/*=========================================================================
+ SPI CLOCK RATES
+ -----------------------------------------------------------------------
+ The steps tried when tuning the clock, up to the 10 MHz maximum of the
+ datasheet, and the reads made at each step to verify it.
+ -----------------------------------------------------------------------*/
+static const int numBusSpeeds = 7;
+static const uint32_t busSpeeds[numBusSpeeds] = {500000, 1000000, 2000000, 4000000, 5000000, 8000000, 10000000};
+static const int busSpeedVerifyReads = 16;
 /*=========================================================================*/
 
 /*=========================================================================
@@ -101,8 +129,80 @@ typedef struct
 } bmp183_calib_data;
 /*=========================================================================*/
 
+/*=========================================================================
+ SAMPLE DATA
+ -----------------------------------------------------------------------*/
+typedef struct
+{
+    int64_t  timestamp;         // microseconds since the epoch
+    int32_t  rawTemperature;    // UT
+    int32_t  rawPressure;       // UP
+    int32_t  pressure;          // compensated station pressure in Pa, filtered if a filter is set
+    int32_t  unfilteredPressure; // compensated station pressure in Pa, before the filter
+    int32_t  temperature;       // compensated temperature in 0.01 C
+    uint8_t  mode;              // bmp183_mode_t used for the conversion
+} bmp183_sample;
+
+static const int sampleBufferSize = 1024;
+/*=========================================================================*/
+
+/*=========================================================================
+ RUNTIME CONFIGURATION
+ -----------------------------------------------------------------------
+ Settings which may change while samples are taken. Each sample reads one
+ snapshot, so all its steps agree, and changes never wait on a conversion.
+ -----------------------------------------------------------------------*/
+typedef struct
+{
+    int32_t  stationAltitude;   // m, for sea level pressure
+    int32_t  latencyBudget;     // us, or zero for the fixed operating mode
+    int32_t  temperatureReuse;  // ms, or zero to convert temperature every sample
+    uint32_t filterVersion;     // changed whenever the filter is replaced
+    uint8_t  operatingMode;     // bmp183_mode_t, the ceiling under a latency budget
+    SampleFilter filter;        // pressure filter settings, taking no state from here
+} bmp183_config;
+/*=========================================================================*/
 
-class Bmp183Drv : public spibus::SPIDevice  {
+/*=========================================================================
+ SPLIT-PHASE CONVERSION
+ -----------------------------------------------------------------------*/
+struct Bmp183Conversion
+{
+    std::unique_lock<std::mutex> lock;  // the bus, held from start until the sample is complete
+    bmp183_config settings;             // snapshot every step of the sample agrees on
+    bmp183_sample sample;
+    bool temperatureNeeded;
+    bool pressureStarted;
+    uint64_t failures;                  // bus failures before the sample, to detect new ones
+    std::chrono::steady_clock::time_point start;
+};
+/*=========================================================================*/
+
+/*=========================================================================
+ STATISTICS
+ -----------------------------------------------------------------------*/
+struct Bmp183Stats
+{
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> corrupt;      // samples dropped for a failed transfer or stuck data word
+    stats::Histogram conversionWait;    // time asleep waiting on conversions
+    stats::Histogram compensation;      // raw to compensated values
+    stats::Histogram formatting;        // value to string
+    
+    Bmp183Stats() { reset(); }
+    
+    void reset() {
+        samples = 0;
+        corrupt = 0;
+        conversionWait.reset();
+        compensation.reset();
+        formatting.reset();
+    }
+};
+/*=========================================================================*/
+
+
+class Bmp183Drv {
     
 public:
     // Sorry about all the constructors--they're needed because the last two parameters are
@@ -110,6 +210,9 @@ public:
     Bmp183Drv(std::string devfile);
     Bmp183Drv(std::string devfile, int altitude);
     Bmp183Drv(std::string devfile, int altitude, int operationMode);
+    Bmp183Drv(bus::BusDevice *device, int altitude, int operationMode);
+    static Bmp183Drv* create(std::string devfile, int altitude, int operationMode);
+    ~Bmp183Drv();
     
     static std::string getVersion();
     static std::string getDeviceName();
@@ -121,13 +224,76 @@ public:
     bool isActive();
     std::string getValueByName(std::string name);
     std::string getValueAtIndex(int index);
+    std::string getValueAtIndex(int index, int &mode);
+    float getFloatAtIndex(int index);
+    float getFloatAtIndex(int index, int &mode);
+    
+    // Reads a value whose index is known at compile time, as in read<descriptor.indexOf("pressure")>()
+    template<int Index>
+    float read() {
+        static_assert(descriptor.contains(Index), "value index out of range");
+        return (this->*(descriptor.values[Index].reader))();
+    }
     bool setOperatingMode(int operationMode);
+    bool setLatencyBudget(int microseconds);
+    bool setSampleRate(float hertz);
+    bool setTemperatureReuse(int milliseconds);
+    void setFilter(const SampleFilter &filter);
+    void setStationAltitude(int altitude);
+    int getStationAltitude();
+    int getLastMode();
+    
+    bool startSampling(float floorHertz, float ceilingHertz);
+    void stopSampling();
+    bool isSampling();
+    bool setCadenceThresholds(float rateThreshold, float varianceThreshold);
+    int getSampleInterval();
+    bool getLatestSample(bmp183_sample &sample);
+    bool readSample(bmp183_sample &sample);
+    int startConversion(Bmp183Conversion &conversion);
+    int continueConversion(Bmp183Conversion &conversion);
+    bool setReadAhead(int milliseconds);
+    uint64_t getSampleCount();
+    size_t exportSamples(TelemetryEncoder &encoder, uint64_t since, char *out, size_t size, uint64_t &next, size_t &count);
+    int getSampleEventFd();
+    size_t drainSamples(uint64_t since, bmp183_sample *samples, size_t count, uint64_t &next);
+    
+    bool startRecording(std::string filename);
+    void stopRecording();
+    bool isRecording();
+    const bmp183_calib_data& getCalibration();
+    
+    bool openHistory(std::string directory);
+    void closeHistory();
+    HistoryStore* getHistory();
+    
+    uint32_t tuneSpeed(uint32_t maxSpeed);
+    uint32_t getBusSpeed();
+    
+    bus::BusStats& getBusStats();
+    Bmp183Stats& getStats();
+    void resetStats();
+    
+    static void compensate(const bmp183_calib_data &coeffs, bmp183_sample &sample);
+    static void filter(SampleFilter &filter, bmp183_sample &sample);
+    static float seaLevelPressure(float pressure_mb, int stationAltitude);
     
 protected:
     
     bool initialize();
-    std::string readValue0();
-    std::string readValue1();
+    float readValue0();
+    float readValue1();
+    float readPressure(int &mode);
+    
+public:
+    
+    static constexpr sensor::SensorDescriptor<Bmp183Drv, numValues> descriptor = {
+        "BMP183", "sensor", "0.8.0",
+        {
+            { "pressure", "float", &Bmp183Drv::readValue0 },
+            { "temperature", "float", &Bmp183Drv::readValue1 }
+        }
+    };
     
 private:
     void activate();
@@ -135,18 +301,83 @@ private:
     float  getPressure();
     float pressureToAltitude(float seaLevel, float atmospheric, float temp);
     float seaLevelForAltitude(float altitude, float atmospheric, float temp);
-    float seaLevelPressure(float pressure_mb, int stationAltitude);
-    void readCoefficients(void);
+    bool acquireSample(bmp183_sample &sample);
+    bool getReadySample(bmp183_sample &sample);
+    bool sampleIsFresh();
+    void requestPrefetch();
+    void startWorker();
+    void stopWorker();
+    void samplingLoop();
+    void signalSamples();
+    void configure(int altitude, int operationMode);
+    bmp183_mode_t selectMode(const bmp183_config &settings, bool temperatureNeeded);
+    bool temperatureIsFresh(const bmp183_config &settings);
+    bool verifySpeed(uint32_t speed, const bmp183_calib_data &reference);
+    void backOffSpeed();
+    static bool calibrationIsValid(const bmp183_calib_data &coeffs);
+    void readCoefficients(bmp183_calib_data &coeffs);
     int16_t readRawTemperature();
-    int32_t readRawPressure();
+    void startTemperatureConversion();
+    int16_t readTemperatureConversion();
+    void startPressureConversion(bmp183_mode_t mode);
+    int32_t readPressureConversion(bmp183_mode_t mode);
     uint16_t readUnsigned16(uint32_t registerAddress);
-    int16_t readSigned16(uint32_t registerAddress);
     uint16_t combineRegisters(unsigned char msb, unsigned char lsb);
 
+    bus::BusDevice *device;
+    uint32_t controlRegister = BMP183_REGISTER_CONTROL;
     bool active = false;
-    int stationAltitude;
     bmp183_calib_data bmp183_coeffs;
-    bmp183_mode_t operatingMode = BMP183_MODE_ULTRAHIGHRES;
+    
+    // Mode of the last conversion, written under busMutex and read without it by getLastMode
+    std::atomic<int> lastMode{BMP183_MODE_ULTRAHIGHRES};
+    
+    // Mode, altitude and filter settings, read without locking by every sample
+    SeqLock<bmp183_config> config;
+    
+    // Adaptive mode scheduling overhead, guarded by busMutex
+    int conversionOverhead = 0;
+    
+    // Smoothing of the compensated pressure, and the settings version it was built from, guarded by busMutex
+    SampleFilter pressureFilter;
+    uint32_t filterVersion = 0;
+    
+    // Index into busSpeeds of the tuned clock, or -1 while the clock is untuned
+    int busSpeedStep = -1;
+    
+    Bmp183Stats driverStats;
+    int16_t lastRawTemperature = 0;
+    std::chrono::steady_clock::time_point lastTemperatureTime;
+    
+    // Serializes conversions between the sampler and on-demand reads
+    std::mutex busMutex;
+    
+    // Raw capture of every acquired sample, with its own lock so that starting or stopping
+    // a capture never waits out a conversion
+    std::mutex recorderMutex;
+    Bmp183Recorder *recorder = 0;
+    
+    // Persistent history of every acquired sample, with its own lock like the recorder
+    std::mutex historyMutex;
+    HistoryStore *history = 0;
+    
+    // Worker thread for background sampling and read-ahead, and its buffer of recent samples
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<bool> sampling{false};
+    std::atomic<int> readAhead{0};
+    bool prefetchPending = false;
+    bool prefetchInFlight = false;
+    std::mutex sampleMutex;
+    std::condition_variable samplerSignal;
+    std::condition_variable sampleReady;
+    SampleCadence cadence;
+    bmp183_sample samples[sampleBufferSize];
+    uint64_t sampleCount = 0;
+    
+    // Pollable descriptor signalled when samples land, once until drained, guarded by sampleMutex
+    int sampleEventFd = -1;
+    bool sampleEventSignalled = false;
         
 };
 
@@ -0,0 +1,364 @@
+/**
+ * \file Bmp183Emulator.cpp
+ *
+ *  Register map, conversion timing, waveforms and fault injection of the emulated BMP183.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Bmp183Emulator.h"
+
+// Register map
+static const uint8_t REG_CALIBRATION = 0xAA;
+static const uint8_t REG_CHIPID = 0xD0;
+static const uint8_t REG_VERSION = 0xD1;
+static const uint8_t REG_SOFTRESET = 0xE0;
+static const uint8_t REG_CONTROL = 0xF4;
+static const uint8_t REG_DATA = 0xF6;
+
+static const uint8_t CMD_TEMPERATURE = 0x2E;
+static const uint8_t CMD_PRESSURE = 0x34;
+static const uint8_t CMD_RESET = 0xB6;
+static const uint8_t CONTROL_SCO = 0x20;
+
+// Calibration EEPROM, from the datasheet example: AC1..AC6, B1, B2, MB, MC, MD
+static const int16_t calibration[11] = { 408, -72, -14383, (int16_t)32741, (int16_t)32757, 23153, 6190, 4, -32768, -8711, 2868 };
+
+// Maximum conversion times in microseconds
+static const int temperatureTime = 4500;
+static const int pressureTime[4] = { 4500, 7500, 13500, 25500 };
+
+// Pressure noise relative to ultra high resolution, per the datasheet RMS noise figures
+static const float noiseFactor[4] = { 2.0F, 1.67F, 1.33F, 1.0F };
+
+// Chance that a byte read above the maximum reliable clock rate is corrupted
+static const float overspeedErrorRate = 0.1F;
+
+Bmp183Emulator::Bmp183Emulator() : spibus::SPIDevice() {
+    bmp183_waveform calmPressure = { 1013.25F, 0, 0, 86400, 0 };
+    bmp183_waveform calmTemperature = { 20.0F, 0, 0, 86400, 0 };
+    bmp183_faults noFaults = { 0, 0, 0, false, 0x55 };
+    
+    this->pressure = calmPressure;
+    this->temperature = calmTemperature;
+    this->faults = noFaults;
+    this->timeScale = 1.0F;
+    this->speed = 500000;
+    this->startTime = std::chrono::steady_clock::now();
+    this->random.seed(183);
+    
+    this->reset();
+    this->open();
+}
+
+int Bmp183Emulator::open() {
+    this->opened = true;
+    return 0;
+}
+
+bool Bmp183Emulator::isOpen() {
+    return this->opened;
+}
+
+void Bmp183Emulator::close() {
+    this->opened = false;
+}
+
+/**
+ * Sets the pressure signal, in hPa, which conversions will measure
+ */
+void Bmp183Emulator::setPressure(bmp183_waveform waveform) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->pressure = waveform;
+}
+
+/**
+ * Sets the temperature signal, in degrees C, which conversions will measure
+ */
+void Bmp183Emulator::setTemperature(bmp183_waveform waveform) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->temperature = waveform;
+}
+
+void Bmp183Emulator::setFaults(bmp183_faults faults) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->faults = faults;
+    this->registers[REG_CHIPID] = faults.chipId;
+}
+
+/**
+ * Scales conversion times, where 1 is real time and 0 makes conversions complete instantly
+ */
+void Bmp183Emulator::setTimeScale(float scale) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->timeScale = (scale < 0) ? 0 : scale;
+}
+
+void Bmp183Emulator::setSeed(uint32_t seed) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->random.seed(seed);
+}
+
+float Bmp183Emulator::pressureAt(double seconds) {
+    return this->pressure.base + this->pressure.slope * seconds +
+           this->pressure.amplitude * sin(2 * M_PI * seconds / this->pressure.period);
+}
+
+float Bmp183Emulator::temperatureAt(double seconds) {
+    return this->temperature.base + this->temperature.slope * seconds +
+           this->temperature.amplitude * sin(2 * M_PI * seconds / this->temperature.period);
+}
+
+/**
+ * Carries out one SPI transfer. The first byte is the register address, with the top bit set
+ * for a read. Reads auto-increment the address, while writes are address and data pairs.
+ */
+int Bmp183Emulator::message(struct spi_ioc_transfer *transfer) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    const uint8_t *send = (const uint8_t *)(uintptr_t)transfer->tx_buf;
+    uint8_t *receive = (uint8_t *)(uintptr_t)transfer->rx_buf;
+    int length = transfer->len;
+    
+    if (!this->opened) {
+        errno = EBADF;
+        return -1;
+    }
+    
+    if (this->chance(this->faults.transferFailureRate)) {
+        errno = EIO;
+        return -1;
+    }
+    
+    if ((length < 1) || (send == 0)) {
+        return length;
+    }
+    
+    this->updateConversion();
+    
+    if (send[0] & 0x80) {
+        float errorRate = this->faults.bitErrorRate;
+        if ((this->faults.maxReliableSpeed > 0) && (this->speed > this->faults.maxReliableSpeed)) {
+            errorRate += overspeedErrorRate;
+        }
+        
+        receive[0] = 0;
+        for (int i = 1; i < length; i++) {
+            uint8_t value = this->readByte((uint8_t)(send[0] + i - 1));
+            if (this->chance(errorRate)) {
+                value ^= (uint8_t)(1 << (this->random() % 8));
+            }
+            receive[i] = value;
+        }
+    }
+    else {
+        // A write address has the top bit cleared
+        for (int i = 0; i + 1 < length; i += 2) {
+            this->writeByte(send[i] | 0x80, send[i + 1]);
+        }
+    }
+    
+    return length;
+}
+
+int Bmp183Emulator::control(unsigned long request, void *arg) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    if (!this->opened) {
+        errno = EBADF;
+        return -1;
+    }
+    
+    if (request == SPI_IOC_WR_MAX_SPEED_HZ) {
+        this->speed = *(uint32_t *)arg;
+    }
+    
+    return 0;
+}
+
+void Bmp183Emulator::reset() {
+    memset(this->registers, 0, sizeof this->registers);
+    
+    for (int i = 0; i < 11; i++) {
+        this->registers[REG_CALIBRATION + 2 * i] = (uint8_t)((uint16_t)calibration[i] >> 8);
+        this->registers[REG_CALIBRATION + 2 * i + 1] = (uint8_t)calibration[i];
+    }
+    
+    this->registers[REG_CHIPID] = this->faults.chipId;
+    this->registers[REG_VERSION] = 0x02;
+    
+    this->converting = false;
+    this->lastB5 = this->temperatureB5(this->rawTemperatureFor(this->temperature.base));
+}
+
+void Bmp183Emulator::writeByte(uint8_t address, uint8_t value) {
+    if (address == REG_CONTROL) {
+        this->startConversion(value);
+    }
+    else if ((address == REG_SOFTRESET) && (value == CMD_RESET)) {
+        this->reset();
+    }
+}
+
+uint8_t Bmp183Emulator::readByte(uint8_t address) {
+    return this->registers[address];
+}
+
+void Bmp183Emulator::startConversion(uint8_t command) {
+    double now = this->elapsedSeconds();
+    int duration;
+    
+    // The true temperature always drives the pressure reading, whatever UT the host last saw
+    int32_t ut = this->rawTemperatureFor(this->temperatureAt(now) + this->noise(this->temperature.noise));
+    this->lastB5 = this->temperatureB5(ut);
+    
+    if (command == CMD_TEMPERATURE) {
+        this->pendingResult = ut;
+        this->pendingShift = 8;
+        duration = temperatureTime;
+    }
+    else if ((command & 0x3F) == CMD_PRESSURE) {
+        int oss = command >> 6;
+        float hPa = this->pressureAt(now) + this->noise(this->pressure.noise * noiseFactor[oss]);
+        this->pendingResult = this->rawPressureFor(hPa, this->lastB5, oss);
+        this->pendingShift = 8 - oss;
+        duration = pressureTime[oss];
+    }
+    else {
+        return;
+    }
+    
+    this->registers[REG_CONTROL] = command | CONTROL_SCO;
+    this->converting = true;
+    this->conversionDone = std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t)(duration * this->timeScale));
+}
+
+/**
+ * Latches the result of a conversion into the data registers once its time has elapsed
+ */
+void Bmp183Emulator::updateConversion() {
+    if (!this->converting || this->faults.stuckConversion) {
+        return;
+    }
+    
+    if (std::chrono::steady_clock::now() < this->conversionDone) {
+        return;
+    }
+    
+    uint32_t raw = (uint32_t)this->pendingResult << this->pendingShift;
+    this->registers[REG_DATA] = (uint8_t)(raw >> 16);
+    this->registers[REG_DATA + 1] = (uint8_t)(raw >> 8);
+    this->registers[REG_DATA + 2] = (uint8_t)raw;
+    this->registers[REG_CONTROL] &= ~CONTROL_SCO;
+    this->converting = false;
+}
+
+double Bmp183Emulator::elapsedSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->startTime).count();
+}
+
+float Bmp183Emulator::noise(float deviation) {
+    if (deviation <= 0) {
+        return 0;
+    }
+    
+    std::normal_distribution<float> distribution(0, deviation);
+    return distribution(this->random);
+}
+
+bool Bmp183Emulator::chance(float probability) {
+    if (probability <= 0) {
+        return false;
+    }
+    
+    std::uniform_real_distribution<float> distribution(0, 1);
+    return distribution(this->random) < probability;
+}
+
+/**
+ * Datasheet temperature compensation, up to the intermediate B5 shared with pressure
+ */
+int32_t Bmp183Emulator::temperatureB5(int32_t ut) {
+    int32_t x1 = ((ut - (int32_t)(uint16_t)calibration[5]) * (int32_t)(uint16_t)calibration[4]) >> 15;
+    int32_t x2 = ((int32_t)calibration[9] << 11) / (x1 + calibration[10]);
+    return x1 + x2;
+}
+
+/**
+ * Datasheet pressure compensation, in Pa
+ */
+int32_t Bmp183Emulator::pressureFromRaw(int32_t up, int32_t b5, int oss) {
+    int32_t b6 = b5 - 4000;
+    int32_t x1 = (calibration[7] * ((b6 * b6) >> 12)) >> 11;
+    int32_t x2 = (calibration[1] * b6) >> 11;
+    int32_t x3 = x1 + x2;
+    int32_t b3 = ((((int32_t)calibration[0] * 4 + x3) << oss) + 2) / 4;
+    x1 = (calibration[2] * b6) >> 13;
+    x2 = (calibration[6] * ((b6 * b6) >> 12)) >> 16;
+    x3 = ((x1 + x2) + 2) >> 2;
+    uint32_t b4 = ((uint32_t)(uint16_t)calibration[3] * (uint32_t)(x3 + 32768)) >> 15;
+    uint32_t b7 = ((uint32_t)up - b3) * (50000 >> oss);
+    int32_t p = (b7 < 0x80000000) ? (b7 * 2) / b4 : (b7 / b4) * 2;
+    x1 = (p >> 8) * (p >> 8);
+    x1 = (x1 * 3038) >> 16;
+    x2 = (-7357 * p) >> 16;
+    return p + ((x1 + x2 + 3791) >> 4);
+}
+
+/**
+ * Finds the raw temperature which compensates to the given temperature, by bisection
+ */
+int32_t Bmp183Emulator::rawTemperatureFor(float celsius) {
+    // Below this UT the compensation divides by zero or less and is no longer monotonic
+    int32_t low = (uint16_t)calibration[5] - ((int32_t)calibration[10] << 15) / (uint16_t)calibration[4] + 2;
+    int32_t high = 65535;
+    int32_t target = (int32_t)lroundf(celsius * 160) - 8;
+    
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        if (this->temperatureB5(mid) < target) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+/**
+ * Finds the raw pressure which compensates to the given pressure, by bisection
+ */
+int32_t Bmp183Emulator::rawPressureFor(float hPa, int32_t b5, int oss) {
+    int32_t low = 0;
+    int32_t high = (1 << (16 + oss)) - 1;
+    int32_t target = (int32_t)lroundf(hPa * 100);
+    
+    // Raw values below B3 wrap around in the compensation, so start from there
+    int32_t b6 = b5 - 4000;
+    int32_t x3 = ((calibration[7] * ((b6 * b6) >> 12)) >> 11) + ((calibration[1] * b6) >> 11);
+    int32_t b3 = ((((int32_t)calibration[0] * 4 + x3) << oss) + 2) / 4;
+    if (b3 > low) {
+        low = b3;
+    }
+    
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        if (this->pressureFromRaw(mid, b5, oss) < target) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
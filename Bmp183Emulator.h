@@ -0,0 +1,113 @@
+/**
+ * \file Bmp183Emulator.h
+ *
+ *  Software BMP183 on the SPI interface, for running the driver without hardware.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __Bmp183Emulator__
+#define __Bmp183Emulator__
+
+#include <stdint.h>
+#include <chrono>
+#include <random>
+#include <mutex>
+#include "SPIDevice.h"
+
+/*=========================================================================
+ SIGNAL AND FAULT SETTINGS
+ -----------------------------------------------------------------------*/
+typedef struct
+{
+    float base;         // value at time zero
+    float slope;        // linear drift per second
+    float amplitude;    // amplitude of the sinusoidal component
+    float period;       // period of the sinusoidal component in seconds
+    float noise;        // standard deviation of gaussian noise, at ultra high resolution
+} bmp183_waveform;
+
+typedef struct
+{
+    float    transferFailureRate;   // probability that a transfer fails outright
+    float    bitErrorRate;          // probability that a byte read has one bit flipped
+    uint32_t maxReliableSpeed;      // clock rate above which every byte read risks a bit flip, 0 for none
+    bool     stuckConversion;       // conversions never complete, leaving stale data
+    uint8_t  chipId;                // value of the chip ID register
+} bmp183_faults;
+/*=========================================================================*/
+
+/**
+ * @class Bmp183Emulator
+ * @brief Software model of a BMP183 behind the SPIDevice interface.
+ *
+ * The model has the BMP183 register map, a calibration EEPROM, chip ID 0x55, and conversions which
+ * take their datasheet time for each oversampling setting. Raw readings are generated from
+ * configurable pressure and temperature waveforms by inverting the datasheet compensation, so the
+ * driver reads them back as the intended values. Faults can be injected to exercise error handling.
+ */
+class Bmp183Emulator : public spibus::SPIDevice {
+    
+public:
+    Bmp183Emulator();
+    
+    virtual int open();
+    virtual bool isOpen();
+    virtual void close();
+    
+    void setPressure(bmp183_waveform waveform);
+    void setTemperature(bmp183_waveform waveform);
+    void setFaults(bmp183_faults faults);
+    void setTimeScale(float scale);
+    void setSeed(uint32_t seed);
+    
+    float pressureAt(double seconds);
+    float temperatureAt(double seconds);
+    
+protected:
+    virtual int message(struct spi_ioc_transfer *transfer);
+    virtual int control(unsigned long request, void *arg);
+    
+private:
+    void reset();
+    void writeByte(uint8_t address, uint8_t value);
+    uint8_t readByte(uint8_t address);
+    void startConversion(uint8_t command);
+    void updateConversion();
+    double elapsedSeconds();
+    float noise(float deviation);
+    bool chance(float probability);
+    int32_t temperatureB5(int32_t ut);
+    int32_t pressureFromRaw(int32_t up, int32_t b5, int oss);
+    int32_t rawTemperatureFor(float celsius);
+    int32_t rawPressureFor(float hPa, int32_t b5, int oss);
+    
+    uint8_t registers[256];
+    bool opened;
+    uint32_t speed;
+    
+    bmp183_waveform pressure;
+    bmp183_waveform temperature;
+    bmp183_faults faults;
+    float timeScale;
+    
+    // A conversion in progress, and the raw result it will latch when done
+    bool converting;
+    std::chrono::steady_clock::time_point conversionDone;
+    int32_t pendingResult;
+    int pendingShift;
+    int32_t lastB5;
+    
+    std::chrono::steady_clock::time_point startTime;
+    std::mt19937 random;
+    std::mutex lock;
+};
+
+#endif /* __Bmp183Emulator__ */
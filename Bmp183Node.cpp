@@ -13,6 +13,8 @@
  */
 
 #include "Bmp183Node.h"
+#include "Bmp183ArrayNode.h"
+#include <climits>
 
 namespace bmp183 {
     
@@ -29,9 +31,32 @@ namespace bmp183 {
     using v8::Value;
     using v8::Number;
     using v8::Boolean;
+    using v8::Array;
+    using v8::ArrayBuffer;
+    using v8::Float64Array;
+    using v8::Float32Array;
+    using v8::Uint32Array;
     
     Persistent<Function> Bmp183Node::constructor;
     Bmp183Drv* Bmp183Node::driver = 0;
+    stats::Histogram Bmp183Node::queueDelay;
+    stats::Histogram Bmp183Node::workTime;
+    stats::Histogram Bmp183Node::completionDelay;
+    TelemetryEncoder Bmp183Node::telemetry;
+    Bmp183Node::Work Bmp183Node::workPool[maxQueueLimit + 1];
+    Bmp183Node::Work* Bmp183Node::freeWork = 0;
+    Bmp183Node::Work* Bmp183Node::pendingHead = 0;
+    Bmp183Node::Work* Bmp183Node::pendingTail = 0;
+    Persistent<Function> Bmp183Node::droppedCallbacks[maxDropped];
+    int Bmp183Node::numDropped = 0;
+    uv_async_t Bmp183Node::droppedSignal;
+    int Bmp183Node::pendingDepth = 0;
+    bool Bmp183Node::workRunning = false;
+    int Bmp183Node::queueLimit = 32;
+    Bmp183Node::QUEUE_POLICY Bmp183Node::queuePolicy = Bmp183Node::QUEUE_COALESCE;
+    uint64_t Bmp183Node::rejectedRequests = 0;
+    uint64_t Bmp183Node::coalescedRequests = 0;
+    uint64_t Bmp183Node::droppedRequests = 0;
     
     void Bmp183Node::Init(Local<Object> exports) {
         Isolate* isolate = exports->GetIsolate();
@@ -55,18 +80,62 @@ namespace bmp183 {
         NODE_SET_PROTOTYPE_METHOD(tpl, "valueAtIndexSync", getValueAtIndexSync);
         NODE_SET_PROTOTYPE_METHOD(tpl, "valueAtIndex", getValueAtIndex);
         NODE_SET_PROTOTYPE_METHOD(tpl, "operatingMode", setOperatingMode);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "latencyBudget", setLatencyBudget);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "sampleRate", setSampleRate);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "temperatureReuse", setTemperatureReuse);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "filter", setFilter);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "stationAltitude", setStationAltitude);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "lastMode", getLastMode);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "startSampling", startSampling);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "stopSampling", stopSampling);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "cadenceThresholds", setCadenceThresholds);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "sampleInterval", getSampleInterval);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "readAhead", setReadAhead);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "startRecording", startRecording);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "stopRecording", stopRecording);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "openHistory", openHistory);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "closeHistory", closeHistory);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "history", getHistory);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "encodeSamples", encodeSamples);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "decodeSamples", decodeSamples);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "telemetryFormat", setTelemetryFormat);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "exportSamples", exportSamples);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "tuneSpeed", tuneSpeed);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "busSpeed", getBusSpeed);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "stats", getStats);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "resetStats", resetStats);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "statsEnabled", setStatsEnabled);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "requestQueue", setRequestQueue);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "queueStatus", getQueueStatus);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "startTrace", startTrace);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "stopTrace", stopTrace);
 
+        // every request slot starts out free
+        for (int i = 0; i < maxQueueLimit + 1; i++) {
+            workPool[i].request.data = &workPool[i];
+            workPool[i].next = (i < maxQueueLimit) ? &workPool[i + 1] : 0;
+        }
+        freeWork = &workPool[0];
+        
+        // dropped requests are answered from the event loop, which this only keeps alive while any wait
+        uv_async_init(uv_default_loop(), &droppedSignal, droppedAsync);
+        uv_unref((uv_handle_t *)&droppedSignal);
+        
         // store a reference to this constructor
         constructor.Reset(isolate, tpl->GetFunction());
         
         exports->Set(String::NewFromUtf8(isolate, "Bmp183"), tpl->GetFunction());
     }
     
+    // Builds a JS string straight from the driver's compile-time metadata
+    static Local<String> metadataString(Isolate* isolate, sensor::StrRef str) {
+        return String::NewFromUtf8(isolate, str.data(), String::kInternalizedString, str.size());
+    }
+    
     void Bmp183Node::getDeviceName(const FunctionCallbackInfo<Value>& args) {
         Isolate* isolate = args.GetIsolate();
         
-        std::string name = Bmp183Drv::getDeviceName();
-        Local<String> deviceName = String::NewFromUtf8(isolate, name.c_str());
+        Local<String> deviceName = metadataString(isolate, Bmp183Drv::descriptor.name);
         
         args.GetReturnValue().Set(deviceName);
     }
@@ -74,8 +143,7 @@ namespace bmp183 {
     void Bmp183Node::getDeviceType(const FunctionCallbackInfo<Value>& args) {
         Isolate* isolate = args.GetIsolate();
         
-        std::string type = Bmp183Drv::getDeviceType();
-        Local<String> deviceType = String::NewFromUtf8(isolate, type.c_str());
+        Local<String> deviceType = metadataString(isolate, Bmp183Drv::descriptor.type);
         
         args.GetReturnValue().Set(deviceType);
     }
@@ -101,8 +169,9 @@ namespace bmp183 {
     void Bmp183Node::getTypeAtIndex (const FunctionCallbackInfo<Value>& args) {
         Isolate* isolate = args.GetIsolate();
         
-        std::string type = driver->getTypeAtIndex(args[0]->NumberValue());
-        Local<String> valType = String::NewFromUtf8(isolate, type.c_str());
+        int index = args[0]->NumberValue();
+        sensor::StrRef type = Bmp183Drv::descriptor.contains(index) ? Bmp183Drv::descriptor.values[index].type : sensor::StrRef("none");
+        Local<String> valType = metadataString(isolate, type);
         
         args.GetReturnValue().Set(valType);
     }
@@ -110,8 +179,9 @@ namespace bmp183 {
     void Bmp183Node::getNameAtIndex (const FunctionCallbackInfo<Value>& args) {
         Isolate* isolate = args.GetIsolate();
         
-        std::string name = driver->getNameAtIndex(args[0]->NumberValue());
-        Local<String> valName = String::NewFromUtf8(isolate, name.c_str());
+        int index = args[0]->NumberValue();
+        sensor::StrRef name = Bmp183Drv::descriptor.contains(index) ? Bmp183Drv::descriptor.values[index].name : sensor::StrRef("none");
+        Local<String> valName = metadataString(isolate, name);
         
         args.GetReturnValue().Set(valName);
     }
@@ -137,20 +207,145 @@ namespace bmp183 {
     void Bmp183Node::getValueAtIndex (const FunctionCallbackInfo<Value>& args) {
         Isolate* isolate = args.GetIsolate();
         
-        Work * work = new Work();
-        work->request.data = work;
-        
         // get the desired value index from the first param in the JS call
-        work->valueIndex = args[0]->NumberValue();
-        
-        // store the callback from JS in the work package so we can invoke it later
+        int valueIndex = args[0]->NumberValue();
         Local<Function> callback = Local<Function>::Cast(args[1]);
-        work->callback.Reset(isolate, callback);
+        
+        // A full queue is handled by the policy, so that overload sheds requests rather than growing
+        if (pendingDepth >= queueLimit) {
+            if (queuePolicy == QUEUE_COALESCE) {
+                for (Work *pending = pendingHead; pending != 0; pending = pending->next) {
+                    if ((pending->valueIndex == valueIndex) && (pending->numCallbacks < maxCoalesced)) {
+                        pending->callbacks[pending->numCallbacks++].Reset(isolate, callback);
+                        coalescedRequests++;
+                        args.GetReturnValue().Set(Boolean::New(isolate, true));
+                        return;
+                    }
+                }
+            }
+            
+            // A rejected request is answered by the false return alone, so it never takes a slot
+            if ((queuePolicy != QUEUE_DROP_OLDEST) || (pendingHead == 0) || !dropOldest()) {
+                rejectedRequests++;
+                args.GetReturnValue().Set(Boolean::New(isolate, false));
+                return;
+            }
+        }
+        
+        Work *work = takeWork();
+        
+        work->valueIndex = valueIndex;
+        work->callbacks[0].Reset(isolate, callback);
+        work->numCallbacks = 1;
+        work->timed = stats::isEnabled();
+        work->queued = std::chrono::steady_clock::now();
+        work->next = 0;
+        
+        if (pendingTail != 0) {
+            pendingTail->next = work;
+        }
+        else {
+            pendingHead = work;
+        }
+        pendingTail = work;
+        pendingDepth++;
+        
+        dispatchWork();
+        
+        args.GetReturnValue().Set(Boolean::New(isolate, true));
+    }
+    
+    // The pool holds the largest queue plus the request converting, and a request leaves the
+    // queue before another takes its slot, so it never runs dry
+    Bmp183Node::Work* Bmp183Node::takeWork() {
+        Work *work = freeWork;
+        freeWork = work->next;
+        
+        return work;
+    }
+    
+    void Bmp183Node::releaseWork(Work *work) {
+        for (int i = 0; i < work->numCallbacks; i++) {
+            work->callbacks[i].Reset();
+        }
+        work->numCallbacks = 0;
+        work->next = freeWork;
+        freeWork = work;
+    }
+    
+    // Starts the oldest pending request if none is converting, as conversions are serialized anyway
+    void Bmp183Node::dispatchWork() {
+        if (workRunning || (pendingHead == 0)) {
+            return;
+        }
+        
+        Work *work = pendingHead;
+        pendingHead = work->next;
+        if (pendingHead == 0) {
+            pendingTail = 0;
+        }
+        pendingDepth--;
+        workRunning = true;
         
         // kick of the worker thread
         uv_queue_work(uv_default_loop(),&work->request,WorkAsync,WorkAsyncComplete);
+    }
+    
+    // Drops the oldest pending request, freeing its slot at once. Its callbacks are kept to be
+    // answered on a later tick, as completed ones are, so that no callback runs from inside
+    // valueAtIndex. Returns false if too many already wait for that tick to keep these as well.
+    bool Bmp183Node::dropOldest() {
+        Work *work = pendingHead;
         
-        args.GetReturnValue().Set(Undefined(isolate));
+        if (numDropped + work->numCallbacks > maxDropped) {
+            return false;
+        }
+        
+        Isolate * isolate = Isolate::GetCurrent();
+        
+        v8::HandleScope handleScope(isolate);
+        
+        for (int i = 0; i < work->numCallbacks; i++) {
+            droppedCallbacks[numDropped++].Reset(isolate, Local<Function>::New(isolate, work->callbacks[i]));
+        }
+        
+        pendingHead = work->next;
+        if (pendingHead == 0) {
+            pendingTail = 0;
+        }
+        pendingDepth--;
+        droppedRequests++;
+        
+        releaseWork(work);
+        
+        uv_ref((uv_handle_t *)&droppedSignal);
+        uv_async_send(&droppedSignal);
+        
+        return true;
+    }
+    
+    // called by libuv in event loop after requests have been dropped
+    void Bmp183Node::droppedAsync(uv_async_t *handle) {
+        Isolate * isolate = Isolate::GetCurrent();
+        
+        v8::HandleScope handleScope(isolate);
+        
+        Handle<Value> argv[] = { v8::Exception::Error(String::NewFromUtf8(isolate, "BMP183 request dropped from a full queue")) };
+        
+        // Take the callbacks first, as they may drop more requests
+        Local<Function> callbacks[maxDropped];
+        int numCallbacks = numDropped;
+        
+        for (int i = 0; i < numCallbacks; i++) {
+            callbacks[i] = Local<Function>::New(isolate, droppedCallbacks[i]);
+            droppedCallbacks[i].Reset();
+        }
+        numDropped = 0;
+        uv_unref((uv_handle_t *)&droppedSignal);
+        
+        for (int i = 0; i < numCallbacks; i++) {
+            callbacks[i]->Call(isolate->GetCurrentContext()->Global(), 1, argv);
+        }
     }
     
     void Bmp183Node::setOperatingMode (const FunctionCallbackInfo<Value>& args) {
@@ -162,6 +357,515 @@ namespace bmp183 {
         args.GetReturnValue().Set(modeResult);
     }
     
+    void Bmp183Node::setLatencyBudget (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        double budget = args[0]->NumberValue();
+        
+        // NaN, or a budget beyond an int, can't be truncated to one
+        bool result = (budget >= 0) && (budget <= INT_MAX) && driver->setLatencyBudget((int)budget);
+        Local<Boolean> budgetResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(budgetResult);
+    }
+    
+    void Bmp183Node::setSampleRate (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        bool result = driver->setSampleRate(args[0]->NumberValue());
+        Local<Boolean> rateResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(rateResult);
+    }
+    
+    void Bmp183Node::setTemperatureReuse (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        bool result = driver->setTemperatureReuse(args[0]->NumberValue());
+        Local<Boolean> reuseResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(reuseResult);
+    }
+    
+    // filter('iir', coefficient), filter('kalman', processNoise, measurementNoise) or filter('none')
+    void Bmp183Node::setFilter (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        std::string type = args[0]->IsUndefined() ? "none" : *v8::String::Utf8Value(args[0]->ToString());
+        SampleFilter filter;
+        bool result = true;
+        
+        if (type == "iir") {
+            result = filter.setIIR(args[1]->IsUndefined() ? 4 : args[1]->Int32Value());
+        }
+        else if (type == "kalman") {
+            result = filter.setKalman(args[1]->IsUndefined() ? 1 : args[1]->NumberValue(),
+                                      args[2]->IsUndefined() ? 0 : args[2]->NumberValue());
+        }
+        else if (type != "none") {
+            result = false;
+        }
+        
+        if (result) {
+            driver->setFilter(filter);
+        }
+        
+        Local<Boolean> filterResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(filterResult);
+    }
+    
+    // Changes the station altitude in meters while running, if given, and returns the altitude in use
+    void Bmp183Node::setStationAltitude (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        if (!args[0]->IsUndefined()) {
+            driver->setStationAltitude(args[0]->Int32Value());
+        }
+        
+        Local<Number> altitude = Number::New(isolate, driver->getStationAltitude());
+        
+        args.GetReturnValue().Set(altitude);
+    }
+    
+    void Bmp183Node::getLastMode (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        int mode = driver->getLastMode();
+        Local<Number> lastMode = Number::New(isolate, mode);
+        
+        args.GetReturnValue().Set(lastMode);
+    }
+    
+    void Bmp183Node::startSampling (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        float floorHertz = args[0]->IsUndefined() ? 0.1 : args[0]->NumberValue();
+        float ceilingHertz = args[1]->IsUndefined() ? 10 : args[1]->NumberValue();
+        
+        bool result = driver->startSampling(floorHertz, ceilingHertz);
+        Local<Boolean> samplingResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(samplingResult);
+    }
+    
+    void Bmp183Node::stopSampling (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        driver->stopSampling();
+        
+        args.GetReturnValue().Set(Undefined(isolate));
+    }
+    
+    void Bmp183Node::setCadenceThresholds (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        bool result = driver->setCadenceThresholds(args[0]->NumberValue(), args[1]->NumberValue());
+        Local<Boolean> thresholdResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(thresholdResult);
+    }
+    
+    void Bmp183Node::getSampleInterval (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        int interval = driver->getSampleInterval();
+        Local<Number> sampleInterval = Number::New(isolate, interval);
+        
+        args.GetReturnValue().Set(sampleInterval);
+    }
+    
+    void Bmp183Node::setReadAhead (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        bool result = driver->setReadAhead(args[0]->NumberValue());
+        Local<Boolean> readAheadResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(readAheadResult);
+    }
+    
+    void Bmp183Node::startRecording (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        std::string filename = *v8::String::Utf8Value(args[0]->ToString());
+        
+        bool result = driver->startRecording(filename);
+        Local<Boolean> recordingResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(recordingResult);
+    }
+    
+    void Bmp183Node::stopRecording (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        driver->stopRecording();
+        
+        args.GetReturnValue().Set(Undefined(isolate));
+    }
+    
+    void Bmp183Node::openHistory (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        std::string directory = *v8::String::Utf8Value(args[0]->ToString());
+        
+        bool result = driver->openHistory(directory);
+        Local<Boolean> historyResult = Boolean::New(isolate, result);
+        
+        args.GetReturnValue().Set(historyResult);
+    }
+    
+    void Bmp183Node::closeHistory (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        driver->closeHistory();
+        
+        args.GetReturnValue().Set(Undefined(isolate));
+    }
+    
+    // Returns the records of one tier in a time range, in ms, as columns of typed arrays. The
+    // columns share one buffer, filled straight from the mapped ring.
+    void Bmp183Node::getHistory (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        static const char *tierNames[HistoryStore::numTiers] = { "raw", "second", "minute", "hour" };
+        
+        HistoryStore *store = driver->getHistory();
+        std::string tierName = args[0]->IsUndefined() ? "raw" : *v8::String::Utf8Value(args[0]->ToString());
+        int tier = -1;
+        
+        for (int i = 0; i < HistoryStore::numTiers; i++) {
+            if (tierName == tierNames[i]) {
+                tier = i;
+            }
+        }
+        
+        if ((store == 0) || (tier < 0)) {
+            args.GetReturnValue().Set(Undefined(isolate));
+            return;
+        }
+        
+        int64_t from = args[1]->IsUndefined() ? 0 : (int64_t)(args[1]->NumberValue() * 1000);
+        int64_t to = args[2]->IsUndefined() ? INT64_MAX : (int64_t)(args[2]->NumberValue() * 1000);
+        
+        size_t capacity = store->count(tier, from, to);
+        
+        // Timestamps first to keep them 8 byte aligned, then counts, then six float columns
+        size_t size = capacity * (sizeof(double) + sizeof(uint32_t) + 6 * sizeof(float));
+        char *data = (char *)malloc(size ? size : 1);
+        double *timestamp = (double *)data;
+        uint32_t *count = (uint32_t *)(timestamp + capacity);
+        float *column[6];
+        for (int i = 0; i < 6; i++) {
+            column[i] = (float *)(count + capacity) + i * capacity;
+        }
+        
+        // Inserts may land between count and scan, so only what fits is taken
+        size_t filled = 0;
+        store->scan(tier, from, to, [&](const history_record &record) {
+            if (filled == capacity) {
+                return false;
+            }
+            timestamp[filled] = record.timestamp / 1000.0;
+            count[filled] = record.count;
+            column[0][filled] = record.pressureMin;
+            column[1][filled] = record.pressureMax;
+            column[2][filled] = record.pressureMean;
+            column[3][filled] = record.temperatureMin;
+            column[4][filled] = record.temperatureMax;
+            column[5][filled] = record.temperatureMean;
+            filled++;
+            return true;
+        });
+        
+        // V8 takes ownership of the malloc'd data
+        Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, data, size, ArrayBuffer::kInternalized);
+        static const char *columnNames[6] = { "pressureMin", "pressureMax", "pressureMean", "temperatureMin", "temperatureMax", "temperatureMean" };
+        
+        Local<Object> result = Object::New(isolate);
+        result->Set(String::NewFromUtf8(isolate, "timestamp"), Float64Array::New(buffer, 0, filled));
+        result->Set(String::NewFromUtf8(isolate, "count"), Uint32Array::New(buffer, (char *)count - data, filled));
+        for (int i = 0; i < 6; i++) {
+            result->Set(String::NewFromUtf8(isolate, columnNames[i]), Float32Array::New(buffer, (char *)column[i] - data, filled));
+        }
+        result->Set(String::NewFromUtf8(isolate, "outOfOrder"), Number::New(isolate, (double)store->getOutOfOrder()));
+        
+        args.GetReturnValue().Set(result);
+    }
+    
+    // Compresses series of timestamps in ms, pressures in hPa and temperatures in C, given as
+    // arrays or typed arrays, into a Buffer. An optional timestamp resolution is in ms.
+    void Bmp183Node::encodeSamples (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        if (!args[0]->IsObject() || !args[1]->IsObject() || !args[2]->IsObject()) {
+            args.GetReturnValue().Set(Undefined(isolate));
+            return;
+        }
+        
+        Local<Object> timestamps = args[0]->ToObject();
+        Local<Object> pressures = args[1]->ToObject();
+        Local<Object> temperatures = args[2]->ToObject();
+        int resolution = args[3]->IsUndefined() ? 1 : (int)(args[3]->NumberValue() * 1000);
+        
+        Local<String> lengthKey = String::NewFromUtf8(isolate, "length");
+        size_t count = (size_t)timestamps->Get(lengthKey)->NumberValue();
+        count = std::min(count, (size_t)pressures->Get(lengthKey)->NumberValue());
+        count = std::min(count, (size_t)temperatures->Get(lengthKey)->NumberValue());
+        
+        SampleEncoder encoder(resolution);
+        size_t size = 0;
+        char *data = (char *)malloc(count * SampleEncoder::maxEncodedSize + 1);
+        
+        for (uint32_t i = 0; i < count; i++) {
+            bmp183_sample sample;
+            sample.timestamp = (int64_t)llround(timestamps->Get(i)->NumberValue() * 1000);
+            sample.pressure = (int32_t)lround(pressures->Get(i)->NumberValue() * 100);
+            sample.temperature = (int32_t)lround(temperatures->Get(i)->NumberValue() * 100);
+            
+            size += encoder.encode(sample, (uint8_t *)data + size);
+        }
+        
+        // The Buffer takes ownership of the malloc'd data
+        args.GetReturnValue().Set(node::Buffer::New(isolate, data, size).ToLocalChecked());
+    }
+    
+    // Expands a Buffer from encodeSamples into Float64Arrays of timestamp in ms, pressure in hPa
+    // and temperature in C
+    void Bmp183Node::decodeSamples (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        if (!node::Buffer::HasInstance(args[0])) {
+            args.GetReturnValue().Set(Undefined(isolate));
+            return;
+        }
+        
+        const uint8_t *in = (const uint8_t *)node::Buffer::Data(args[0]);
+        size_t size = node::Buffer::Length(args[0]);
+        
+        // Every sample takes at least three bytes, which bounds the count without a first pass
+        size_t capacity = size / 3;
+        double *data = (double *)malloc(3 * capacity * sizeof(double) + 1);
+        double *column[3] = { data, data + capacity, data + 2 * capacity };
+        
+        SampleDecoder decoder;
+        bmp183_sample sample;
+        size_t count = 0, offset = 0, length;
+        
+        while ((count < capacity) && ((length = decoder.decode(in + offset, size - offset, sample)) > 0)) {
+            column[0][count] = sample.timestamp / 1000.0;
+            column[1][count] = sample.pressure / 100.0;
+            column[2][count] = sample.temperature / 100.0;
+            offset += length;
+            count++;
+        }
+        
+        // V8 takes ownership of the malloc'd data
+        Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, data, 3 * capacity * sizeof(double), ArrayBuffer::kInternalized);
+        
+        Local<Object> result = Object::New(isolate);
+        result->Set(String::NewFromUtf8(isolate, "timestamp"), Float64Array::New(buffer, 0, count));
+        result->Set(String::NewFromUtf8(isolate, "pressure"), Float64Array::New(buffer, capacity * sizeof(double), count));
+        result->Set(String::NewFromUtf8(isolate, "temperature"), Float64Array::New(buffer, 2 * capacity * sizeof(double), count));
+        
+        args.GetReturnValue().Set(result);
+    }
+    
+    // Sets the format of exportSamples, 'line' for InfluxDB line protocol or 'binary', with an
+    // optional measurement name and an object of tags
+    void Bmp183Node::setTelemetryFormat (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        std::string format = args[0]->IsUndefined() ? "line" : *v8::String::Utf8Value(args[0]->ToString());
+        bool success = true;
+        
+        if (format == "line") {
+            telemetry.setFormat(TelemetryEncoder::LINE_PROTOCOL);
+        }
+        else if (format == "binary") {
+            telemetry.setFormat(TelemetryEncoder::BINARY);
+        }
+        else {
+            success = false;
+        }
+        
+        if (success && !args[1]->IsUndefined()) {
+            success = telemetry.setMeasurement(*v8::String::Utf8Value(args[1]->ToString()));
+        }
+        
+        if (success && args[2]->IsObject()) {
+            Local<Object> tags = args[2]->ToObject();
+            Local<Array> keys = tags->GetOwnPropertyNames();
+            
+            telemetry.clearTags();
+            for (uint32_t i = 0; i < keys->Length(); i++) {
+                Local<Value> key = keys->Get(i);
+                success = success && telemetry.addTag(*v8::String::Utf8Value(key->ToString()), *v8::String::Utf8Value(tags->Get(key)->ToString()));
+            }
+        }
+        
+        args.GetReturnValue().Set(Boolean::New(isolate, success));
+    }
+    
+    // Encodes the samples buffered since sample number since in the telemetry format. Returns
+    // the encoded bytes as an ArrayBuffer, the count taken, and next to pass on the next call.
+    void Bmp183Node::exportSamples (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        // NaN or a negative number starts from the oldest sample, as neither can be cast to an integer
+        double requested = args[0]->IsUndefined() ? 0 : args[0]->NumberValue();
+        uint64_t since = (requested > 0) ? (uint64_t)std::min(requested, 9.0e18) : 0;
+        uint64_t available = driver->getSampleCount();
+        uint64_t pending = (available > since) ? std::min(available - since, (uint64_t)sampleBufferSize) : 0;
+        
+        // Samples arriving after the count are left for the next call
+        size_t size = telemetry.maxEncodedSize(pending);
+        char *data = (char *)malloc(size ? size : 1);
+        uint64_t next = since;
+        size_t count = 0;
+        size_t length = driver->exportSamples(telemetry, since, data, size, next, count);
+        
+        // V8 takes ownership of the malloc'd data, encoded in place without a copy
+        Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, data, length, ArrayBuffer::kInternalized);
+        
+        Local<Object> result = Object::New(isolate);
+        result->Set(String::NewFromUtf8(isolate, "data"), buffer);
+        result->Set(String::NewFromUtf8(isolate, "count"), Number::New(isolate, (double)count));
+        result->Set(String::NewFromUtf8(isolate, "next"), Number::New(isolate, (double)next));
+        
+        args.GetReturnValue().Set(result);
+    }
+    
+    static double elapsedMicros(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    }
+    
+    static void setNumber(Isolate* isolate, Local<Object> obj, const char* key, double value) {
+        obj->Set(String::NewFromUtf8(isolate, key), Number::New(isolate, value));
+    }
+    
+    // Summarizes a latency histogram as a JS object, with times in microseconds
+    static Local<Object> histogramObject(Isolate* isolate, const stats::Histogram& histogram) {
+        Local<Object> result = Object::New(isolate);
+        uint64_t count = histogram.getCount();
+        
+        setNumber(isolate, result, "count", count);
+        setNumber(isolate, result, "mean", count ? (double)histogram.getSum() / count : 0);
+        setNumber(isolate, result, "max", histogram.getMax());
+        setNumber(isolate, result, "p50", histogram.getPercentile(0.50));
+        setNumber(isolate, result, "p90", histogram.getPercentile(0.90));
+        setNumber(isolate, result, "p99", histogram.getPercentile(0.99));
+        
+        Local<Array> buckets = Array::New(isolate, stats::Histogram::numBuckets);
+        for (int i = 0; i < stats::Histogram::numBuckets; i++) {
+            buckets->Set(i, Number::New(isolate, histogram.getBucket(i)));
+        }
+        result->Set(String::NewFromUtf8(isolate, "buckets"), buckets);
+        
+        return result;
+    }
+    
+    void Bmp183Node::tuneSpeed (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        uint32_t maxSpeed = args[0]->IsUndefined() ? busSpeeds[numBusSpeeds - 1] : args[0]->Uint32Value();
+        
+        uint32_t speed = driver->tuneSpeed(maxSpeed);
+        Local<Number> tunedSpeed = Number::New(isolate, speed);
+        
+        args.GetReturnValue().Set(tunedSpeed);
+    }
+    
+    void Bmp183Node::getBusSpeed (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        uint32_t speed = driver->getBusSpeed();
+        Local<Number> busSpeed = Number::New(isolate, speed);
+        
+        args.GetReturnValue().Set(busSpeed);
+    }
+    
+    void Bmp183Node::getStats (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        spibus::SPIStats& bus = driver->getBusStats();
+        Bmp183Stats& device = driver->getStats();
+        
+        Local<Object> spi = Object::New(isolate);
+        setNumber(isolate, spi, "transfers", bus.transfers);
+        setNumber(isolate, spi, "bytes", bus.bytes);
+        setNumber(isolate, spi, "failures", bus.failures);
+        setNumber(isolate, spi, "lastError", bus.lastError);
+        spi->Set(String::NewFromUtf8(isolate, "transfer"), histogramObject(isolate, bus.transferTime));
+        
+        Local<Object> result = Object::New(isolate);
+        result->Set(String::NewFromUtf8(isolate, "enabled"), Boolean::New(isolate, stats::isEnabled()));
+        result->Set(String::NewFromUtf8(isolate, "spi"), spi);
+        setNumber(isolate, result, "samples", device.samples);
+        setNumber(isolate, result, "corrupt", device.corrupt);
+        result->Set(String::NewFromUtf8(isolate, "conversionWait"), histogramObject(isolate, device.conversionWait));
+        result->Set(String::NewFromUtf8(isolate, "compensation"), histogramObject(isolate, device.compensation));
+        result->Set(String::NewFromUtf8(isolate, "formatting"), histogramObject(isolate, device.formatting));
+        result->Set(String::NewFromUtf8(isolate, "queueDelay"), histogramObject(isolate, queueDelay));
+        result->Set(String::NewFromUtf8(isolate, "work"), histogramObject(isolate, workTime));
+        result->Set(String::NewFromUtf8(isolate, "completionDelay"), histogramObject(isolate, completionDelay));
+        
+        args.GetReturnValue().Set(result);
+    }
+    
+    void Bmp183Node::resetStats (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        driver->resetStats();
+        queueDelay.reset();
+        workTime.reset();
+        completionDelay.reset();
+        
+        args.GetReturnValue().Set(Undefined(isolate));
+    }
+    
+    void Bmp183Node::setStatsEnabled (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        if (!args[0]->IsUndefined()) {
+            stats::setEnabled(args[0]->BooleanValue());
+        }
+        
+        Local<Boolean> enabled = Boolean::New(isolate, stats::isEnabled());
+        
+        args.GetReturnValue().Set(enabled);
+    }
+    
+    // Starts recording a timeline of bus transfers, conversions and async requests, discarding
+    // any earlier one. An optional argument sets the spans kept per thread.
+    void Bmp183Node::startTrace (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        size_t eventsPerThread = args[0]->IsUndefined() ? trace::defaultEventsPerThread : args[0]->Uint32Value();
+        
+        bool result = trace::start(eventsPerThread);
+        trace::setThreadName("node main");
+        
+        args.GetReturnValue().Set(Boolean::New(isolate, result));
+    }
+    
+    // Stops recording, and writes the timeline as Chrome trace-event JSON to the file given,
+    // returning whether it was written, or returns the JSON as a string
+    void Bmp183Node::stopTrace (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        trace::stop();
+        
+        if (!args[0]->IsUndefined()) {
+            bool result = trace::writeJson(*v8::String::Utf8Value(args[0]->ToString()));
+            args.GetReturnValue().Set(Boolean::New(isolate, result));
+            return;
+        }
+        
+        std::string json = trace::toJson();
+        
+        args.GetReturnValue().Set(String::NewFromUtf8(isolate, json.c_str(), String::kNormalString, json.size()));
+    }
+    
     // NOTE: This addon MUST be invoked as a constructor, as in:
     // var bmp183 = new driver.Bmp183('/dev/spidev1.0', 1750, 3);
     // because there are optional args, and the author doesn't yet
@@ -181,16 +885,89 @@ namespace bmp183 {
         args.GetReturnValue().Set(args.This());
         
         if (!driver) {
-            driver = new Bmp183Drv(devfile, altitude, mode);
+            driver = Bmp183Drv::create(devfile, altitude, mode);
         }
         
     }
     
+    // requestQueue(limit, policy) bounds the requests waiting on valueAtIndex, where policy is
+    // 'reject', 'coalesce' or 'dropOldest'
+    void Bmp183Node::setRequestQueue (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        int limit = args[0]->IsUndefined() ? queueLimit : args[0]->Int32Value();
+        std::string policy = args[1]->IsUndefined() ? "" : *v8::String::Utf8Value(args[1]->ToString());
+        bool result = (limit >= 1) && (limit <= maxQueueLimit);
+        
+        if (result && (policy == "reject")) {
+            queuePolicy = QUEUE_REJECT;
+        }
+        else if (result && (policy == "coalesce")) {
+            queuePolicy = QUEUE_COALESCE;
+        }
+        else if (result && (policy == "dropOldest")) {
+            queuePolicy = QUEUE_DROP_OLDEST;
+        }
+        else if (!policy.empty()) {
+            result = false;
+        }
+        
+        if (result) {
+            queueLimit = limit;
+        }
+        
+        args.GetReturnValue().Set(Boolean::New(isolate, result));
+    }
+    
+    // Depth and limits of the request queue, what overflow has shed, and how long requests wait
+    // before their conversion starts
+    void Bmp183Node::getQueueStatus (const FunctionCallbackInfo<Value>& args) {
+        Isolate* isolate = args.GetIsolate();
+        
+        static const char *policyNames[3] = { "reject", "coalesce", "dropOldest" };
+        
+        Local<Object> result = Object::New(isolate);
+        setNumber(isolate, result, "depth", pendingDepth);
+        setNumber(isolate, result, "converting", workRunning ? 1 : 0);
+        setNumber(isolate, result, "limit", queueLimit);
+        result->Set(String::NewFromUtf8(isolate, "policy"), String::NewFromUtf8(isolate, policyNames[queuePolicy]));
+        setNumber(isolate, result, "rejected", rejectedRequests);
+        setNumber(isolate, result, "coalesced", coalescedRequests);
+        setNumber(isolate, result, "dropped", droppedRequests);
+        result->Set(String::NewFromUtf8(isolate, "wait"), histogramObject(isolate, queueDelay));
+        
+        args.GetReturnValue().Set(result);
+    }
+    
     // called by libuv worker in separate thread
     void Bmp183Node::WorkAsync(uv_work_t *req) {
         Work *work = static_cast<Work *>(req->data);
+        
+        // Named first, so that the worker's trace buffer is set up before the read is timed
+        if (trace::isEnabled()) {
+            trace::setThreadName("libuv worker");
+        }
+        
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        
+        // The wait in the queue is always kept, for queueStatus
+        queueDelay.record(elapsedMicros(work->queued, started));
+        
+        if (trace::isEnabled()) {
+            trace::record("queue wait", "node", work->queued, started, "index", work->valueIndex);
+        }
     
-        work->value = driver->getValueAtIndex(work->valueIndex);
+        work->value = driver->getValueAtIndex(work->valueIndex, work->mode);
+        
+        work->finished = std::chrono::steady_clock::now();
+        
+        if (work->timed) {
+            workTime.record(elapsedMicros(started, work->finished));
+        }
+        
+        if (trace::isEnabled()) {
+            trace::record("valueAtIndex", "node", started, work->finished, "index", work->valueIndex);
+        }
     }
     
     // called by libuv in event loop when async function completes
@@ -200,26 +977,51 @@ namespace bmp183 {
         v8::HandleScope handleScope(isolate);
         
         Work *work = static_cast<Work *>(req->data);
+        std::chrono::steady_clock::time_point completed = std::chrono::steady_clock::now();
+        
+        if (work->timed) {
+            completionDelay.record(elapsedMicros(work->finished, completed));
+        }
+        
+        if (trace::isEnabled()) {
+            trace::setThreadName("node main");
+            trace::record("completion delay", "node", work->finished, completed);
+        }
         
         // the work has been done, and now we store the value as a v8 string
         
         Local<String> retValue = String::NewFromUtf8(isolate, work->value.c_str());
         
-        // set up return arguments: 0 = error, 1 = returned value
-        Handle<Value> argv[] = { Null(isolate) , retValue };
+        // Only pressure has a mode, so temperature and invalid values pass undefined
+        Local<Value> retMode = (work->mode >= 0) ? Local<Value>(Number::New(isolate, work->mode)) : Local<Value>(Undefined(isolate));
+        
+        // set up return arguments: 0 = error, 1 = returned value, 2 = operating mode used
+        Handle<Value> argv[] = { Null(isolate) , retValue, retMode };
         
-        // execute the callback
-        Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), 2, argv);
+        Local<Function> callbacks[maxCoalesced];
+        int numCallbacks = work->numCallbacks;
         
-        // Free up the persistent function callback
-        work->callback.Reset();
-        delete work;
+        for (int i = 0; i < numCallbacks; i++) {
+            callbacks[i] = Local<Function>::New(isolate, work->callbacks[i]);
+        }
+        
+        // Free the slot and start the next conversion before the callbacks, which may queue more
+        releaseWork(work);
+        workRunning = false;
+        dispatchWork();
+        
+        // execute the callbacks
+        trace::ScopedSpan span("callbacks", "node", "count", numCallbacks);
+        for (int i = 0; i < numCallbacks; i++) {
+            callbacks[i]->Call(isolate->GetCurrentContext()->Global(), 3, argv);
+        }
         
     }
 
     void init(Local<Object> exports) {
         
         Bmp183Node::Init(exports);
+        Bmp183ArrayNode::Init(exports);
         
     }
     
@@ -17,12 +17,20 @@
 
 #include <node.h>
 #include <node_object_wrap.h>
+#include <node_buffer.h>
 #include <uv.h>
 #include <iostream>
 #include <cmath>
 #include <string>
 #include <thread>
+#include <chrono>
+#include <algorithm>
 #include "Bmp183Drv.h"
+#include "HistoryStore.h"
+#include "SampleCodec.h"
+#include "TelemetryEncoder.h"
+#include "Stats.h"
+#include "Trace.h"
 
 namespace bmp183 {
     
@@ -41,6 +49,35 @@ public:
     static void getValueAtIndexSync (const v8::FunctionCallbackInfo<v8::Value>& args);
     static void getValueAtIndex (const v8::FunctionCallbackInfo<v8::Value>& args);
     static void setOperatingMode (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setLatencyBudget (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setSampleRate (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setTemperatureReuse (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setFilter (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setStationAltitude (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getLastMode (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void startSampling (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void stopSampling (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setCadenceThresholds (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getSampleInterval (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setReadAhead (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void startRecording (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void stopRecording (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void openHistory (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void closeHistory (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getHistory (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void encodeSamples (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void decodeSamples (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setTelemetryFormat (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void exportSamples (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void tuneSpeed (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getBusSpeed (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getStats (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void resetStats (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setStatsEnabled (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setRequestQueue (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getQueueStatus (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void startTrace (const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void stopTrace (const v8::FunctionCallbackInfo<v8::Value>& args);
     
 private:
     
@@ -57,13 +94,62 @@ private:
     
     static Bmp183Drv *driver;
     
+    // Format and tags of exportSamples
+    static TelemetryEncoder telemetry;
+    
+    // Async work timings: queued to started, started to finished, finished to callback
+    static stats::Histogram queueDelay;
+    static stats::Histogram workTime;
+    static stats::Histogram completionDelay;
+    
+    // What valueAtIndex does with a request when the queue is full
+    enum QUEUE_POLICY {
+        QUEUE_REJECT = 0,       // refuse the new request, returning false
+        QUEUE_COALESCE = 1,     // answer it with a pending request for the same value, else reject
+        QUEUE_DROP_OLDEST = 2   // fail the oldest pending request to make room
+    };
+    
+    static const int maxQueueLimit = 256;
+    static const int maxCoalesced = 8;
+    static const int maxDropped = 256;
+    
     struct Work {
         uv_work_t  request;
-        v8::Persistent<v8::Function> callback;
+        v8::Persistent<v8::Function> callbacks[maxCoalesced];
+        int numCallbacks;
         
         int valueIndex;
         std::string value;
+        int mode;
+        
+        bool timed;
+        std::chrono::steady_clock::time_point queued;
+        std::chrono::steady_clock::time_point finished;
+        
+        Work *next;             // in the pending queue, or the free list
     };
+    
+    static Work* takeWork();
+    static void releaseWork(Work *work);
+    static void dispatchWork();
+    static bool dropOldest();
+    static void droppedAsync(uv_async_t *handle);
+    
+    // Requests are pooled, queued here, and converted one at a time, all on the JS thread
+    static Work workPool[maxQueueLimit + 1];
+    static Work *freeWork;
+    static Work *pendingHead;
+    static Work *pendingTail;
+    static v8::Persistent<v8::Function> droppedCallbacks[maxDropped];
+    static int numDropped;
+    static uv_async_t droppedSignal;
+    static int pendingDepth;
+    static bool workRunning;
+    static int queueLimit;
+    static QUEUE_POLICY queuePolicy;
+    static uint64_t rejectedRequests;
+    static uint64_t coalescedRequests;
+    static uint64_t droppedRequests;
 
     
 };
@@ -0,0 +1,42 @@
+/**
+ * \file BusDevice.cpp
+ *
+ *  Statistics and failure reporting shared by every bus backend.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "BusDevice.h"
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+
+namespace bus {
+
+    BusDevice::~BusDevice() {
+    }
+
+    BusStats& BusDevice::getBusStats(){
+        return this->statistics;
+    }
+
+    /**
+     * Records a failed ioctl in the device statistics and reports it.
+     * @param message The description of the failure
+     * @return -1, for the caller to return
+     */
+    int BusDevice::fail(const char *message){
+        this->statistics.failures.fetch_add(1, std::memory_order_relaxed);
+        this->statistics.lastError = errno;
+        std::cerr << message << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+} /* namespace bus */
@@ -0,0 +1,83 @@
+/**
+ * \file BusDevice.h
+ *
+ *  Register access interface shared by the SPI and I2C backends.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __BusDevice__
+#define __BusDevice__
+
+#include <stdint.h>
+#include <atomic>
+#include "Stats.h"
+#include "Trace.h"
+
+namespace bus {
+
+/**
+ * @struct BusStats
+ * @brief Counters and transfer latency for one bus device. Transfer counts and timings are collected
+ * only while statistics are enabled, while failures are always counted.
+ */
+struct BusStats {
+    std::atomic<uint64_t> transfers;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> failures;
+    std::atomic<int> lastError;
+    stats::Histogram transferTime;
+    
+    BusStats() { reset(); }
+    
+    void reset() {
+        transfers = 0;
+        bytes = 0;
+        failures = 0;
+        lastError = 0;
+        transferTime.reset();
+    }
+};
+
+/**
+ * @class BusDevice
+ * @brief A device with 8 bit registers behind some bus, such as SPI or I2C.
+ *
+ * Drivers program against this interface, so the same driver serves parts which differ only in
+ * the bus they sit on. Register addresses are passed to the bus as given.
+ */
+class BusDevice {
+public:
+    enum BUSTYPE {
+        SPI = 0,
+        I2C = 1
+    };
+    
+    virtual ~BusDevice();
+    
+    virtual BUSTYPE getType() = 0;
+    virtual bool isOpen() = 0;
+    virtual unsigned char readRegister(uint32_t registerAddress) = 0;
+    virtual int readBlock(uint32_t fromAddress, unsigned char *data, uint32_t length) = 0;
+    virtual int writeRegister(uint32_t registerAddress, unsigned char value) = 0;
+    virtual int setSpeed(uint32_t speed) = 0;
+    virtual uint32_t getSpeed() = 0;
+    
+    BusStats& getBusStats();
+    
+protected:
+    BusStats statistics;
+    
+    int fail(const char *message);
+};
+
+} /* namespace bus */
+
+#endif /* __BusDevice__ */
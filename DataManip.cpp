@@ -13,18 +13,22 @@
  */
 
 #include "DataManip.h"
+#include <stdio.h>
 
 std::string DataManip::dataToString(int data) {
     return std::to_string(data);
 }
 
+// Formats a value with a fixed number of decimals, as printf's %.*f does
 std::string DataManip::dataToString(float data, int numDecimals) {
-    int whole = floor(data);
-    int large1 = round(data * pow(10, numDecimals));
-    int large2 = round(whole * pow(10, numDecimals));
-    int fraction = large1 - large2;
+    char buffer[48];
+    int length = snprintf(buffer, sizeof buffer, "%.*f", numDecimals, data);
     
-    return std::to_string(whole) + "." + std::to_string(fraction);
+    if (length < 0) {
+        return "";
+    }
+    
+    return std::string(buffer, (length < (int)sizeof buffer) ? length : sizeof buffer - 1);
 }
 
 std::string DataManip::dataToString(bool data) {
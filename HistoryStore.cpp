@@ -0,0 +1,308 @@
+/**
+ * \file HistoryStore.cpp
+ *
+ *  Ring file management, aggregation on insert, and time range scans.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "HistoryStore.h"
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Seven hours at 10 Hz, a week of seconds, a year of minutes and ten years of hours
+const uint64_t HistoryStore::defaultCapacity[numTiers] = { 262144, 604800, 525600, 87600 };
+const int64_t HistoryStore::tierPeriod[numTiers] = { 0, 1000000LL, 60000000LL, 3600000000LL };
+
+static const char *tierFile[HistoryStore::numTiers] = { "raw.ring", "second.ring", "minute.ring", "hour.ring" };
+
+HistoryStore::HistoryStore() {
+    for (int tier = 0; tier < numTiers; tier++) {
+        this->tiers[tier].mapping = MAP_FAILED;
+        this->tiers[tier].mappingSize = 0;
+        this->tiers[tier].header = 0;
+        this->tiers[tier].records = 0;
+    }
+    
+    this->outOfOrder = 0;
+}
+
+HistoryStore::~HistoryStore() {
+    this->close();
+}
+
+/**
+ * Opens the ring files in a directory, creating the directory and any missing files. An
+ * existing file keeps the capacity it was created with, along with its history.
+ * @param directory where the tier files live
+ * @param capacity records per tier for new files, or null for the defaults
+ * @return false if any tier could not be opened
+ */
+bool HistoryStore::open(std::string directory, const uint64_t *capacity) {
+    this->close();
+    
+    std::lock_guard<std::mutex> lock(this->storeMutex);
+    
+    this->outOfOrder = 0;
+    
+    if ((mkdir(directory.c_str(), 0755) < 0) && (errno != EEXIST)) {
+        std::cerr << "HistoryStore: Can't create " << directory << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    for (int tier = 0; tier < numTiers; tier++) {
+        uint64_t records = capacity ? capacity[tier] : defaultCapacity[tier];
+        
+        if (!this->openTier(tier, directory + "/" + tierFile[tier], records)) {
+            for (int opened = 0; opened < tier; opened++) {
+                munmap(this->tiers[opened].mapping, this->tiers[opened].mappingSize);
+                this->tiers[opened].mapping = MAP_FAILED;
+                this->tiers[opened].header = 0;
+            }
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool HistoryStore::openTier(int tier, std::string filename, uint64_t capacity) {
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    
+    if (fd < 0) {
+        std::cerr << "HistoryStore: Can't open " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) < 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    bool created = (status.st_size == 0);
+    size_t size = created ? sizeof(history_header) + capacity * sizeof(history_record) : status.st_size;
+    
+    // The file is sparse until written, so a large ring costs no disk up front
+    if (created && (capacity == 0 || ftruncate(fd, size) < 0)) {
+        std::cerr << "HistoryStore: Can't size " << filename << std::endl;
+        ::close(fd);
+        return false;
+    }
+    
+    if (size < sizeof(history_header)) {
+        std::cerr << "HistoryStore: " << filename << " is not a history file" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    
+    void *mapped = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    
+    if (mapped == MAP_FAILED) {
+        std::cerr << "HistoryStore: Can't map " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    history_header *header = (history_header *)mapped;
+    
+    if (created) {
+        memcpy(header->magic, historyMagic, sizeof header->magic);
+        header->version = historyVersion;
+        header->recordSize = sizeof(history_record);
+        header->period = tierPeriod[tier];
+        header->capacity = capacity;
+    }
+    else if ((memcmp(header->magic, historyMagic, sizeof header->magic) != 0) ||
+             (header->version != historyVersion) || (header->recordSize != sizeof(history_record)) ||
+             (header->period != tierPeriod[tier]) || (header->capacity == 0) ||
+             (size != sizeof(history_header) + header->capacity * sizeof(history_record))) {
+        std::cerr << "HistoryStore: " << filename << " is not a history file" << std::endl;
+        munmap(mapped, size);
+        return false;
+    }
+    
+    this->tiers[tier].mapping = mapped;
+    this->tiers[tier].mappingSize = size;
+    this->tiers[tier].header = header;
+    this->tiers[tier].records = (history_record *)((char *)mapped + sizeof(history_header));
+    
+    return true;
+}
+
+void HistoryStore::close() {
+    std::lock_guard<std::mutex> lock(this->storeMutex);
+    
+    for (int tier = 0; tier < numTiers; tier++) {
+        if (this->tiers[tier].mapping != MAP_FAILED) {
+            munmap(this->tiers[tier].mapping, this->tiers[tier].mappingSize);
+        }
+        
+        this->tiers[tier].mapping = MAP_FAILED;
+        this->tiers[tier].mappingSize = 0;
+        this->tiers[tier].header = 0;
+        this->tiers[tier].records = 0;
+    }
+}
+
+bool HistoryStore::isOpen() {
+    std::lock_guard<std::mutex> lock(this->storeMutex);
+    return (this->tiers[0].header != 0);
+}
+
+/**
+ * Schedules the mapped pages to be written back. The kernel writes them back on its own, so
+ * this only matters for bounding what a power loss can take.
+ */
+bool HistoryStore::flush() {
+    std::lock_guard<std::mutex> lock(this->storeMutex);
+    bool flushed = true;
+    
+    for (int tier = 0; tier < numTiers; tier++) {
+        if (this->tiers[tier].mapping != MAP_FAILED) {
+            flushed &= (msync(this->tiers[tier].mapping, this->tiers[tier].mappingSize, MS_ASYNC) == 0);
+        }
+    }
+    
+    return flushed;
+}
+
+/**
+ * Adds a sample to the raw tier and folds it into the open aggregate of every other tier,
+ * closing an aggregate into its ring when the sample falls in a new period.
+ * @param timestamp microseconds since the epoch
+ * @param pressure in hPa
+ * @param temperature in C
+ * @return false if the store is closed, or the sample is older than the last one stored
+ */
+bool HistoryStore::insert(int64_t timestamp, float pressure, float temperature) {
+    std::lock_guard<std::mutex> lock(this->storeMutex);
+    
+    if (this->tiers[0].header == 0) {
+        return false;
+    }
+    
+    // A wall clock stepped back would otherwise break the time order, and reopen closed periods
+    history_header *rawHeader = this->tiers[HISTORY_TIER_RAW].header;
+    if ((rawHeader->written > 0) && (timestamp < this->at(HISTORY_TIER_RAW, rawHeader->written - 1).timestamp)) {
+        this->outOfOrder++;
+        return false;
+    }
+    
+    history_record raw;
+    raw.timestamp = timestamp;
+    raw.count = 1;
+    raw.pressureMin = raw.pressureMax = raw.pressureMean = pressure;
+    raw.temperatureMin = raw.temperatureMax = raw.temperatureMean = temperature;
+    raw.reserved = 0;
+    this->append(HISTORY_TIER_RAW, raw);
+    
+    for (int tier = HISTORY_TIER_SECOND; tier < numTiers; tier++) {
+        history_header *header = this->tiers[tier].header;
+        history_record &open = header->open;
+        int64_t start = timestamp - (timestamp % header->period);
+        
+        if ((open.count > 0) && (open.timestamp != start)) {
+            this->append(tier, open);
+            open.count = 0;
+        }
+        
+        if (open.count == 0) {
+            open = raw;
+            open.timestamp = start;
+            open.count = 0;
+            header->pressureSum = 0;
+            header->temperatureSum = 0;
+        }
+        
+        if (pressure < open.pressureMin) open.pressureMin = pressure;
+        if (pressure > open.pressureMax) open.pressureMax = pressure;
+        if (temperature < open.temperatureMin) open.temperatureMin = temperature;
+        if (temperature > open.temperatureMax) open.temperatureMax = temperature;
+        
+        header->pressureSum += pressure;
+        header->temperatureSum += temperature;
+        open.count++;
+        open.pressureMean = header->pressureSum / open.count;
+        open.temperatureMean = header->temperatureSum / open.count;
+    }
+    
+    return true;
+}
+
+void HistoryStore::append(int tier, const history_record &record) {
+    history_header *header = this->tiers[tier].header;
+    
+    this->tiers[tier].records[header->written % header->capacity] = record;
+    header->written++;
+}
+
+const history_record& HistoryStore::at(int tier, uint64_t index) {
+    return this->tiers[tier].records[index % this->tiers[tier].header->capacity];
+}
+
+/**
+ * Finds the first record in the ring at or after a time, assuming records were written in
+ * time order.
+ * @return the index of the record, in records ever written
+ */
+uint64_t HistoryStore::lowerBound(int tier, int64_t timestamp) {
+    history_header *header = this->tiers[tier].header;
+    uint64_t low = (header->written > header->capacity) ? header->written - header->capacity : 0;
+    uint64_t high = header->written;
+    
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        
+        if (this->at(tier, middle).timestamp < timestamp) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+size_t HistoryStore::count(int tier, int64_t from, int64_t to) {
+    return this->scan(tier, from, to, [](const history_record &record) {
+        return true;
+    });
+}
+
+uint64_t HistoryStore::getOutOfOrder() {
+    std::lock_guard<std::mutex> lock(this->storeMutex);
+    return this->outOfOrder;
+}
+
+/**
+ * Copies the records of a tier between two times, as passed by scan
+ * @return the number of records copied, at most maxRecords
+ */
+size_t HistoryStore::query(int tier, int64_t from, int64_t to, history_record *records, size_t maxRecords) {
+    size_t copied = 0;
+    
+    if (maxRecords == 0) {
+        return 0;
+    }
+    
+    this->scan(tier, from, to, [&](const history_record &record) {
+        records[copied++] = record;
+        return (copied < maxRecords);
+    });
+    
+    return copied;
+}
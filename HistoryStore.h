@@ -0,0 +1,167 @@
+/**
+ * \file HistoryStore.h
+ *
+ *  Tiered history of samples and aggregates in memory mapped ring files.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __HistoryStore__
+#define __HistoryStore__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <mutex>
+
+/*=========================================================================
+ TIERS
+ -----------------------------------------------------------------------
+ Raw samples, and aggregates over 1 second, 1 minute and 1 hour periods.
+ -----------------------------------------------------------------------*/
+typedef enum
+{
+    HISTORY_TIER_RAW = 0,
+    HISTORY_TIER_SECOND,
+    HISTORY_TIER_MINUTE,
+    HISTORY_TIER_HOUR
+} history_tier_t;
+/*=========================================================================*/
+
+/*=========================================================================
+ RING FILE FORMAT
+ -----------------------------------------------------------------------
+ Each tier is a fixed size file: a header followed by capacity records,
+ written in a ring. Raw records have a count of 1 and min = max = mean.
+ The header also carries the aggregate still being accumulated, so a
+ period spanning a restart is completed rather than lost.
+ -----------------------------------------------------------------------*/
+static const char historyMagic[8] = { 'B', 'M', 'P', '1', '8', '3', 'H', 'S' };
+static const uint32_t historyVersion = 1;
+
+typedef struct
+{
+    int64_t  timestamp;         // start of the period, microseconds since the epoch
+    uint32_t count;             // samples in the period
+    float    pressureMin;       // hPa
+    float    pressureMax;
+    float    pressureMean;
+    float    temperatureMin;    // C
+    float    temperatureMax;
+    float    temperatureMean;
+    uint32_t reserved;
+} history_record;
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    int64_t  period;            // microseconds, zero for raw samples
+    uint64_t capacity;          // records in the ring
+    uint64_t written;           // records ever written, the next goes to slot written % capacity
+    history_record open;        // aggregate of the current period, if open.count > 0
+    double   pressureSum;
+    double   temperatureSum;
+    uint8_t  reserved[128 - 56 - sizeof(history_record)];
+} history_header;
+/*=========================================================================*/
+
+/**
+ * @class HistoryStore
+ * @brief Memory mapped ring files of raw samples and their 1 s, 1 min and 1 h aggregates.
+ *
+ * Aggregates are updated on every insert, so a tier is always current without a separate
+ * roll-up pass. Inserts and queries may come from different threads. Records are kept in time
+ * order, which the binary search of a query relies on, so a sample older than the last one
+ * stored, as after the clock is stepped back, is rejected and counted.
+ */
+class HistoryStore {
+    
+public:
+    static const int numTiers = 4;
+    static const uint64_t defaultCapacity[numTiers];
+    static const int64_t tierPeriod[numTiers];
+    
+    HistoryStore();
+    ~HistoryStore();
+    
+    bool open(std::string directory, const uint64_t *capacity = 0);
+    void close();
+    bool isOpen();
+    bool flush();
+    
+    bool insert(int64_t timestamp, float pressure, float temperature);
+    size_t count(int tier, int64_t from, int64_t to);
+    size_t query(int tier, int64_t from, int64_t to, history_record *records, size_t maxRecords);
+    uint64_t getOutOfOrder();
+    
+    /**
+     * Passes the records of a tier between two times to visit, oldest first, straight from the
+     * mapped ring. The aggregate of the current, unfinished period is passed last. Inserts wait
+     * until the scan is done, and visit may return false to stop early.
+     * @param tier a history_tier_t
+     * @param from the earliest time included, in microseconds since the epoch
+     * @param to the time after the last included
+     * @return the number of records passed to visit
+     */
+    template<class Visitor>
+    size_t scan(int tier, int64_t from, int64_t to, Visitor visit) {
+        std::lock_guard<std::mutex> lock(this->storeMutex);
+        
+        if ((tier < 0) || (tier >= numTiers) || (this->tiers[tier].header == 0)) {
+            return 0;
+        }
+        
+        history_header *header = this->tiers[tier].header;
+        size_t found = 0;
+        
+        for (uint64_t index = this->lowerBound(tier, from); index < header->written; index++) {
+            const history_record &record = this->at(tier, index);
+            
+            if (record.timestamp >= to) {
+                break;
+            }
+            
+            found++;
+            if (!visit(record)) {
+                return found;
+            }
+        }
+        
+        const history_record &open = header->open;
+        
+        if ((tier != HISTORY_TIER_RAW) && (open.count > 0) && (open.timestamp >= from) && (open.timestamp < to)) {
+            found++;
+            visit(open);
+        }
+        
+        return found;
+    }
+    
+private:
+    bool openTier(int tier, std::string filename, uint64_t capacity);
+    void append(int tier, const history_record &record);
+    const history_record& at(int tier, uint64_t index);
+    uint64_t lowerBound(int tier, int64_t timestamp);
+    
+    struct Tier {
+        void *mapping;
+        size_t mappingSize;
+        history_header *header;
+        history_record *records;
+    };
+    
+    Tier tiers[numTiers];
+    uint64_t outOfOrder;        // inserts rejected as older than the last record, since opened
+    std::mutex storeMutex;
+};
+
+#endif /* __HistoryStore__ */
@@ -0,0 +1,168 @@
+/**
+ * \file I2CDevice.cpp
+ *
+ *  Combined write-then-read I2C_RDWR transactions over i2c-dev.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "I2CDevice.h"
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+namespace i2cbus {
+
+    /**
+     * The constructor for the I2CDevice that opens the bus. The destructor closes it.
+     * @param devfile the bus, such as /dev/i2c-1
+     * @param address the 7 bit address of the device on the bus
+     */
+    I2CDevice::I2CDevice(std::string devfile, uint16_t address) {
+        this->file = -1;
+        
+        this->filename = devfile;
+        this->address = address;
+        
+        this->open();
+    }
+
+    bus::BusDevice::BUSTYPE I2CDevice::getType(){
+        return bus::BusDevice::I2C;
+    }
+
+    /**
+     * This method opens the file connection to the I2C bus.
+     * @return 0 on a successful open of the file
+     */
+    int I2CDevice::open(){
+        if ((this->file = ::open(filename.c_str(), O_RDWR))<0){
+            std::cerr << "I2CDevice: Can't open bus " << filename << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    bool I2CDevice::isOpen(){
+        return (this->file >= 0);
+    }
+
+    /**
+     * Submits one or more messages as a single transaction, with a repeated start between them.
+     * @return -1 on failure
+     */
+    int I2CDevice::transfer(struct i2c_msg *messages, int count){
+        struct i2c_rdwr_ioctl_data transaction;
+        transaction.msgs = messages;
+        transaction.nmsgs = count;
+        
+        stats::ScopedTimer timer(this->statistics.transferTime);
+        trace::ScopedSpan span("i2c transfer", "bus", "messages", count);
+        int status = this->message(&transaction);
+        if (status < 0) {
+            return this->fail("I2CDevice: I2C_RDWR Failed");
+        }
+        
+        if (stats::isEnabled()) {
+            int bytes = 0;
+            for (int i = 0; i < count; i++) {
+                bytes += messages[i].len;
+            }
+            this->statistics.transfers.fetch_add(1, std::memory_order_relaxed);
+            this->statistics.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        
+        return status;
+    }
+
+    /**
+     * Submits a transaction to the bus. Derived classes may override this to talk to something
+     * other than an i2c-dev file.
+     * @return the number of messages transferred, or -1 with errno set on failure
+     */
+    int I2CDevice::message(struct i2c_rdwr_ioctl_data *transaction){
+        return ioctl(this->file, I2C_RDWR, transaction);
+    }
+
+    unsigned char I2CDevice::readRegister(uint32_t registerAddress){
+        unsigned char value = 0;
+        this->readBlock(registerAddress, &value, 1);
+        return value;
+    }
+
+    /**
+     * Reads consecutive registers in one combined write-then-read transaction.
+     * @param fromAddress the first register
+     * @param data where to store the values read
+     * @param length the number of registers to read
+     * @return -1 on failure
+     */
+    int I2CDevice::readBlock(uint32_t fromAddress, unsigned char *data, uint32_t length){
+        unsigned char registerAddress = (unsigned char) fromAddress;
+        struct i2c_msg messages[2];
+        
+        messages[0].addr = this->address;
+        messages[0].flags = 0;
+        messages[0].len = 1;
+        messages[0].buf = &registerAddress;
+        
+        messages[1].addr = this->address;
+        messages[1].flags = I2C_M_RD;
+        messages[1].len = (uint16_t) length;
+        messages[1].buf = data;
+        
+        return (this->transfer(messages, 2) < 0) ? -1 : 0;
+    }
+
+    int I2CDevice::writeRegister(uint32_t registerAddress, unsigned char value){
+        unsigned char send[2];
+        send[0] = (unsigned char) registerAddress;
+        send[1] = value;
+        
+        struct i2c_msg message;
+        message.addr = this->address;
+        message.flags = 0;
+        message.len = 2;
+        message.buf = send;
+        
+        return (this->transfer(&message, 1) < 0) ? -1 : 0;
+    }
+
+    /**
+     * The clock of an i2c-dev bus is fixed by the adapter configuration, so it can't be set here.
+     * @return -1 with errno set to EOPNOTSUPP
+     */
+    int I2CDevice::setSpeed(uint32_t){
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    /**
+     * @return 0, as the clock of an i2c-dev bus is not known to user space
+     */
+    uint32_t I2CDevice::getSpeed(){
+        return 0;
+    }
+
+    void I2CDevice::close(){
+        if (this->file >= 0) {
+            ::close(this->file);
+        }
+        this->file = -1;
+    }
+
+    I2CDevice::~I2CDevice() {
+        this->close();
+    }
+
+} /* namespace i2cbus */
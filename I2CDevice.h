@@ -0,0 +1,65 @@
+/**
+ * \file I2CDevice.h
+ *
+ *  i2c-dev backend of the bus interface, for the BMP085 and BMP180.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __I2CDevice__
+#define __I2CDevice__
+
+#include <string>
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "BusDevice.h"
+
+namespace i2cbus {
+
+/**
+ * @class I2CDevice
+ * @brief A register device on a Linux i2c-dev bus.
+ *
+ * Each register access is a single I2C_RDWR ioctl. A read is one combined transaction that
+ * writes the register address and reads the data back after a repeated start, so a block of
+ * registers costs one system call however long it is.
+ */
+class I2CDevice : public bus::BusDevice {
+    
+private:
+    std::string filename;
+    uint16_t address;
+
+public:
+    I2CDevice(std::string devfile, uint16_t address);
+    virtual BUSTYPE getType();
+    virtual int open();
+    virtual bool isOpen();
+    virtual unsigned char readRegister(uint32_t registerAddress);
+    virtual int readBlock(uint32_t fromAddress, unsigned char *data, uint32_t length);
+    virtual int writeRegister(uint32_t registerAddress, unsigned char value);
+    virtual int setSpeed(uint32_t speed);
+    virtual uint32_t getSpeed();
+    virtual void close();
+    virtual ~I2CDevice();
+    
+protected:
+    int file;
+    
+    virtual int message(struct i2c_rdwr_ioctl_data *transaction);
+    
+private:
+    int transfer(struct i2c_msg *messages, int count);
+};
+
+} /* namespace i2cbus */
+
+#endif /* __I2CDevice__ */
@@ -35,6 +35,23 @@ namespace spibus {
         this->open();
     }
 
+    /**
+     * Constructor for derived devices which do not talk to a device file, such as emulators.
+     * Nothing is opened, and the derived class provides message() and control().
+     */
+    SPIDevice::SPIDevice() {
+        this->file=-1;
+        
+        this->mode = SPIDevice::MODE3;
+        this->bits = 8;
+        this->speed = 500000;
+        this->delay = 0;
+    }
+
+
+    bus::BusDevice::BUSTYPE SPIDevice::getType(){
+        return bus::BusDevice::SPI;
+    }
 
     /**
      * This method opens the file connection to the SPI device.
@@ -62,20 +79,51 @@ namespace spibus {
      */
     int SPIDevice::transfer(unsigned char send[], unsigned char receive[], int length){
         struct spi_ioc_transfer	transfer;
+        memset(&transfer, 0, sizeof transfer);
         transfer.tx_buf = (uint64_t) send;
         transfer.rx_buf = (uint64_t) receive;
         transfer.len = length;
         transfer.speed_hz = this->speed;
         transfer.bits_per_word = this->bits;
         transfer.delay_usecs = this->delay;
-        int status = ioctl(this->file, SPI_IOC_MESSAGE(1), &transfer);
+        
+        stats::ScopedTimer timer(this->statistics.transferTime);
+        trace::ScopedSpan span("spi transfer", "bus", "bytes", length);
+        int status = this->message(&transfer);
         if (status < 0) {
-            std::cerr << "SPIDevice: SPI_IOC_MESSAGE Failed" << std::endl;
-            return -1;
+            return this->fail("SPIDevice: SPI_IOC_MESSAGE Failed");
+        }
+        
+        if (stats::isEnabled()) {
+            this->statistics.transfers.fetch_add(1, std::memory_order_relaxed);
+            this->statistics.bytes.fetch_add(length, std::memory_order_relaxed);
         }
+        
         return status;
     }
 
+    /**
+     * Submits a single transfer to the device. Derived classes may override this to talk to
+     * something other than a spidev file.
+     * @return the number of bytes transferred, or -1 with errno set on failure
+     */
+    int SPIDevice::message(struct spi_ioc_transfer *transfer){
+        return ioctl(this->file, SPI_IOC_MESSAGE(1), transfer);
+    }
+
+    /**
+     * Applies a configuration request, such as SPI_IOC_WR_MODE, to the device. Derived classes
+     * may override this along with message().
+     * @return -1 with errno set on failure
+     */
+    int SPIDevice::control(unsigned long request, void *arg){
+        return ioctl(this->file, request, arg);
+    }
+
+    bool SPIDevice::isOpen(){
+        return (this->file >= 0);
+    }
+
     unsigned char SPIDevice::readRegister(uint32_t registerAddress){
         unsigned char send[2], receive[2];
         memset(send, 0, sizeof send);
@@ -87,6 +135,24 @@ namespace spibus {
     }
 
         
+    /**
+     * Reads consecutive registers in a single transfer, relying on the device to auto-increment
+     * the address as the BMP183 does.
+     * @param fromAddress the first register, as sent on the bus
+     * @param data where to store the values read
+     * @param length the number of registers to read
+     * @return -1 on failure
+     */
+    int SPIDevice::readBlock(uint32_t fromAddress, unsigned char *data, uint32_t length){
+        unsigned char send[length+1], receive[length+1];
+        memset(send, 0, sizeof send);
+        memset(receive, 0, sizeof receive);
+        send[0] = (unsigned char) fromAddress;
+        int status = this->transfer(send, receive, length+1);
+        memcpy(data, receive+1, length);
+        return (status < 0) ? -1 : 0;
+    }
+
     unsigned char* SPIDevice::readRegisters(uint32_t number, uint32_t fromAddress){
         unsigned char* data = new unsigned char[number];
         unsigned char send[number+1], receive[number+1];
@@ -136,43 +202,41 @@ namespace spibus {
 
     int SPIDevice::setSpeed(uint32_t speed){
         this->speed = speed;
-        if (ioctl(this->file, SPI_IOC_WR_MAX_SPEED_HZ, &this->speed)==-1){
-            std::cerr << "SPIDevice: Can't set max speed HZ" << std::endl;
-            return -1;
+        if (this->control(SPI_IOC_WR_MAX_SPEED_HZ, &this->speed)==-1){
+            return this->fail("SPIDevice: Can't set max speed HZ");
         }
-        if (ioctl(this->file, SPI_IOC_RD_MAX_SPEED_HZ, &this->speed)==-1){
-            std::cerr << "SPIDevice: Can't get max speed HZ." << std::endl;
-            return -1;
+        if (this->control(SPI_IOC_RD_MAX_SPEED_HZ, &this->speed)==-1){
+            return this->fail("SPIDevice: Can't get max speed HZ");
         }
         return 0;
     }
 
     int SPIDevice::setMode(SPIDevice::SPIMODE mode){
         this->mode = mode;
-        if (ioctl(this->file, SPI_IOC_WR_MODE, &this->mode)==-1){
-            std::cerr << "SPIDevice: Can't set SPI mode." << std::endl;
-            return -1;
+        if (this->control(SPI_IOC_WR_MODE, &this->mode)==-1){
+            return this->fail("SPIDevice: Can't set SPI mode");
         }
-        if (ioctl(this->file, SPI_IOC_RD_MODE, &this->mode)==-1){
-            std::cerr << "SPIDevice: Can't get SPI mode." << std::endl;
-            return -1;
+        if (this->control(SPI_IOC_RD_MODE, &this->mode)==-1){
+            return this->fail("SPIDevice: Can't get SPI mode");
         }
         return 0;
     }
 
     int SPIDevice::setBitsPerWord(uint8_t bits){
         this->bits = bits;
-        if (ioctl(this->file, SPI_IOC_WR_BITS_PER_WORD, &this->bits)==-1){
-            std::cerr << "SPIDevice: Can't set bits per word." << std::endl;
-            return -1;
+        if (this->control(SPI_IOC_WR_BITS_PER_WORD, &this->bits)==-1){
+            return this->fail("SPIDevice: Can't set bits per word");
         }
-        if (ioctl(this->file, SPI_IOC_RD_BITS_PER_WORD, &this->bits)==-1){
-            std::cerr << "SPIDevice: Can't get bits per word." << std::endl;
-            return -1;
+        if (this->control(SPI_IOC_RD_BITS_PER_WORD, &this->bits)==-1){
+            return this->fail("SPIDevice: Can't get bits per word");
         }
         return 0;
     }
 
+    uint32_t SPIDevice::getSpeed(){
+        return this->speed;
+    }
+
     void SPIDevice::close(){
         ::close(this->file);
         this->file = -1;
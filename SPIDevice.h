@@ -30,16 +30,22 @@
 #include <sys/ioctl.h>
 #include <linux/types.h>
 #include <linux/spi/spidev.h>
+#include <errno.h>
+#include <atomic>
+#include "BusDevice.h"
 
 #define HEX(x) std::setw(2) << std::setfill('0') << std::hex << (int)(x)
 
 namespace spibus {
 
+// Kept for code written before the bus interface was shared with I2C
+typedef bus::BusStats SPIStats;
+
 /**
  * @class SPIDevice
  * @brief Generic SPI Device class that can be used to connect to any type of SPI device and read or write to its registers
  */
-class SPIDevice {
+class SPIDevice : public bus::BusDevice {
 public:
     /// The SPI Mode
     enum SPIMODE{
@@ -54,8 +60,11 @@ private:
 
 public:
 	SPIDevice(std::string devfile);
+    virtual BUSTYPE getType();
     virtual int open();
+    virtual bool isOpen();
 	virtual unsigned char readRegister(uint32_t registerAddress);
+	virtual int readBlock(uint32_t fromAddress, unsigned char *data, uint32_t length);
 	virtual unsigned char* readRegisters(uint32_t number, uint32_t fromAddress=0);
 	virtual int writeRegister(uint32_t registerAddress, unsigned char value);
 	virtual void debugDumpRegisters(uint32_t number = 0xff);
@@ -65,11 +74,17 @@ public:
 	virtual int setMode(SPIDevice::SPIMODE mode);
 	virtual int setBitsPerWord(uint8_t bits);
 	virtual void close();
+    virtual uint32_t getSpeed();
 	virtual ~SPIDevice();
 
 protected:
+    SPIDevice();
+    
     int file;
     
+    virtual int message(struct spi_ioc_transfer *transfer);
+    virtual int control(unsigned long request, void *arg);
+    
 private:
 	virtual int transfer(unsigned char read[], unsigned char write[], int length);
 	SPIMODE mode;
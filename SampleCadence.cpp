@@ -0,0 +1,133 @@
+/**
+ * \file SampleCadence.cpp
+ *
+ *  Rate of change and variance tracking behind the adaptive sampling interval.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "SampleCadence.h"
+
+// Time constant of the estimators in seconds, so smoothing is independent of the sampling rate
+static const float smoothingTime = 10.0F;
+
+// Factor by which the interval grows on each calm sample
+static const float backoffFactor = 1.25F;
+
+SampleCadence::SampleCadence() {
+    this->minInterval = 100000;
+    this->maxInterval = 10000000;
+    this->rateThreshold = 0.005F;
+    this->varianceThreshold = 0.01F;
+    
+    this->reset();
+}
+
+/**
+ * Sets the range within which the sampling rate may vary.
+ * @param floorHertz the slowest rate, used while pressure is stable
+ * @param ceilingHertz the fastest rate, used while pressure is changing
+ * @return false if the rates are not positive or the floor exceeds the ceiling
+ */
+bool SampleCadence::setRates(float floorHertz, float ceilingHertz) {
+    if ((floorHertz <= 0) || (ceilingHertz <= 0) || (floorHertz > ceilingHertz)) {
+        return false;
+    }
+    
+    this->minInterval = (int)(1000000 / ceilingHertz);
+    this->maxInterval = (int)(1000000 / floorHertz);
+    this->interval = this->minInterval;
+    
+    return true;
+}
+
+/**
+ * Sets the levels at which the cadence ramps up to the ceiling rate.
+ * @param rateThreshold absolute rate of change of pressure, in hPa per second
+ * @param varianceThreshold variance of pressure about its running mean, in hPa squared
+ */
+bool SampleCadence::setThresholds(float rateThreshold, float varianceThreshold) {
+    if ((rateThreshold <= 0) || (varianceThreshold <= 0)) {
+        return false;
+    }
+    
+    this->rateThreshold = rateThreshold;
+    this->varianceThreshold = varianceThreshold;
+    
+    return true;
+}
+
+/**
+ * Folds a new pressure reading into the estimators and returns the interval to the next sample.
+ * @param pressure the pressure reading in hPa
+ * @param timestamp the time of the reading in microseconds
+ * @return the interval to the next sample in microseconds
+ */
+int SampleCadence::update(float pressure, int64_t timestamp) {
+    
+    if (!this->primed) {
+        this->primed = true;
+        this->lastTimestamp = timestamp;
+        this->mean = pressure;
+        return this->interval;
+    }
+    
+    float seconds = (timestamp - this->lastTimestamp) / 1000000.0F;
+    
+    if (seconds <= 0) {
+        return this->interval;
+    }
+    
+    // Weight of this observation, scaled by the time since the last one
+    float gain = 1.0F - expf(-seconds / smoothingTime);
+    
+    // Holt's linear smoothing: the rate is the trend of the smoothed level, not of the raw
+    // readings, so sensor noise at high sampling rates does not register as a change
+    float diff = pressure - (this->mean + this->rate * seconds);
+    float previousMean = this->mean;
+    this->mean += this->rate * seconds + gain * diff;
+    this->rate += gain * ((this->mean - previousMean) / seconds - this->rate);
+    this->variance = (1.0F - gain) * (this->variance + gain * diff * diff);
+    
+    this->lastTimestamp = timestamp;
+    
+    if ((fabs(this->rate) > this->rateThreshold) || (this->variance > this->varianceThreshold)) {
+        this->interval = this->minInterval;
+    }
+    else {
+        this->interval = (int)(this->interval * backoffFactor);
+        if (this->interval > this->maxInterval) {
+            this->interval = this->maxInterval;
+        }
+    }
+    
+    return this->interval;
+}
+
+int SampleCadence::getInterval() {
+    return this->interval;
+}
+
+float SampleCadence::getRateOfChange() {
+    return this->rate;
+}
+
+float SampleCadence::getVariance() {
+    return this->variance;
+}
+
+void SampleCadence::reset() {
+    this->interval = this->minInterval;
+    this->primed = false;
+    this->lastTimestamp = 0;
+    this->rate = 0;
+    this->mean = 0;
+    this->variance = 0;
+}
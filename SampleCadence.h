@@ -0,0 +1,67 @@
+/**
+ * \file SampleCadence.h
+ *
+ *  Adaptive interval for background sampling, driven by how fast pressure moves.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __SampleCadence__
+#define __SampleCadence__
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @class SampleCadence
+ * @brief Chooses the interval to the next sample from the recent behaviour of the pressure signal.
+ *
+ * The rate of change and the variance of the pressure are tracked with exponentially weighted
+ * estimators, so each update is a handful of arithmetic operations. While both stay below their
+ * thresholds the interval backs off gradually toward the floor rate. As soon as either crosses its
+ * threshold the interval drops straight to the ceiling rate, so no detail is lost during an event.
+ */
+class SampleCadence {
+
+public:
+    
+    SampleCadence();
+    
+    bool setRates(float floorHertz, float ceilingHertz);
+    bool setThresholds(float rateThreshold, float varianceThreshold);
+    int update(float pressure, int64_t timestamp);
+    int getInterval();
+    float getRateOfChange();
+    float getVariance();
+    void reset();
+    
+protected:
+    
+private:
+    
+    // Interval bounds in microseconds
+    int minInterval;
+    int maxInterval;
+    int interval;
+    
+    // Thresholds in hPa per second and hPa squared
+    float rateThreshold;
+    float varianceThreshold;
+    
+    // Incremental estimator state
+    bool primed;
+    int64_t lastTimestamp;
+    float rate;
+    float mean;
+    float variance;
+    
+};
+
+#endif /* __SampleCadence__ */
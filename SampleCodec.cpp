@@ -0,0 +1,257 @@
+/**
+ * \file SampleCodec.cpp
+ *
+ *  Zig-zag varint delta encoder and decoder for sample streams.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "SampleCodec.h"
+
+/*=========================================================================
+ VARINTS
+ -----------------------------------------------------------------------
+ Seven bits per byte, least significant first, with the top bit set on
+ every byte but the last. Signed values are zig-zag mapped first, so that
+ small magnitudes of either sign take few bytes.
+ -----------------------------------------------------------------------*/
+static inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline size_t putVarint(uint64_t value, uint8_t *out) {
+    size_t length = 0;
+    
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    
+    return length;
+}
+
+// Returns the bytes read, or zero if the varint runs past the end or is too long
+static inline size_t getVarint(const uint8_t *in, size_t size, uint64_t &value) {
+    value = 0;
+    
+    for (size_t length = 0; (length < size) && (length < 10); length++) {
+        value |= (uint64_t)(in[length] & 0x7F) << (7 * length);
+        
+        if ((in[length] & 0x80) == 0) {
+            return length + 1;
+        }
+    }
+    
+    return 0;
+}
+/*=========================================================================*/
+
+/**
+ * @param resolution timestamp resolution in microseconds. Timestamps are rounded to it, so a
+ * resolution of 1000 drops sub-millisecond jitter and saves about a byte per sample.
+ */
+SampleEncoder::SampleEncoder(int resolution) {
+    this->resolution = (resolution > 0) ? resolution : 1;
+    this->reset();
+}
+
+/**
+ * Starts a new stream, so the next sample is written after a stream header
+ */
+void SampleEncoder::reset() {
+    this->count = 0;
+    this->lastTimestamp = 0;
+    this->lastDelta = 0;
+    this->lastPressure = 0;
+    this->lastTemperature = 0;
+}
+
+/**
+ * Appends one sample to the stream
+ * @param out where to write, with room for maxEncodedSize bytes
+ * @return the number of bytes written
+ */
+size_t SampleEncoder::encode(const bmp183_sample &sample, uint8_t *out) {
+    size_t length = 0;
+    int64_t timestamp = (sample.timestamp + this->resolution / 2) / this->resolution;
+    
+    if (this->count == 0) {
+        out[length++] = codecMagic;
+        out[length++] = codecVersion;
+        length += putVarint(this->resolution, out + length);
+        length += putVarint(zigzag(timestamp), out + length);
+    }
+    else {
+        int64_t delta = timestamp - this->lastTimestamp;
+        length += putVarint(zigzag((this->count == 1) ? delta : delta - this->lastDelta), out + length);
+        this->lastDelta = delta;
+    }
+    
+    length += putVarint(zigzag((int64_t)sample.pressure - this->lastPressure), out + length);
+    length += putVarint(zigzag((int64_t)sample.temperature - this->lastTemperature), out + length);
+    
+    this->lastTimestamp = timestamp;
+    this->lastPressure = sample.pressure;
+    this->lastTemperature = sample.temperature;
+    this->count++;
+    
+    return length;
+}
+
+/**
+ * Appends as many samples as fit in the output buffer
+ * @param written set to the number of bytes written
+ * @return the number of samples encoded. Samples which did not fit are left for the next call.
+ */
+size_t SampleEncoder::encode(const bmp183_sample *samples, size_t count, uint8_t *out, size_t size, size_t &written) {
+    size_t length = 0, encoded = 0;
+    uint8_t scratch[maxEncodedSize];
+    
+    for (; encoded < count; encoded++) {
+        // Encode straight into the output while there is room for the worst case
+        if (size - length >= maxEncodedSize) {
+            length += this->encode(samples[encoded], out + length);
+            continue;
+        }
+        
+        SampleEncoder saved = *this;
+        size_t needed = this->encode(samples[encoded], scratch);
+        
+        if (needed > size - length) {
+            *this = saved;
+            break;
+        }
+        
+        memcpy(out + length, scratch, needed);
+        length += needed;
+    }
+    
+    written = length;
+    
+    return encoded;
+}
+
+SampleDecoder::SampleDecoder() {
+    this->reset();
+}
+
+/**
+ * Starts on a new stream, so a stream header is expected next
+ */
+void SampleDecoder::reset() {
+    this->resolution = 1;
+    this->count = 0;
+    this->lastTimestamp = 0;
+    this->lastDelta = 0;
+    this->lastPressure = 0;
+    this->lastTemperature = 0;
+}
+
+/**
+ * Reads the next sample from the stream
+ * @param in the encoded bytes, starting at the next sample
+ * @param size the number of bytes available
+ * @param sample the sample to fill in
+ * @return the number of bytes consumed, or zero if the bytes hold no complete sample or are
+ * not a stream
+ */
+size_t SampleDecoder::decode(const uint8_t *in, size_t size, bmp183_sample &sample) {
+    size_t length = 0, read;
+    uint64_t value;
+    int64_t resolution = this->resolution;
+    int64_t timestamp;
+    
+    if (this->count == 0) {
+        if ((size < 2) || (in[0] != codecMagic) || (in[1] != codecVersion)) {
+            return 0;
+        }
+        length = 2;
+        
+        if (!(read = getVarint(in + length, size - length, value)) || (value == 0)) {
+            return 0;
+        }
+        length += read;
+        resolution = value;
+    }
+    
+    if (!(read = getVarint(in + length, size - length, value))) {
+        return 0;
+    }
+    length += read;
+    
+    int64_t delta = this->lastDelta;
+    
+    if (this->count == 0) {
+        timestamp = unzigzag(value);
+    }
+    else {
+        delta = (this->count == 1) ? unzigzag(value) : this->lastDelta + unzigzag(value);
+        timestamp = this->lastTimestamp + delta;
+    }
+    
+    if (!(read = getVarint(in + length, size - length, value))) {
+        return 0;
+    }
+    length += read;
+    int32_t pressure = this->lastPressure + (int32_t)unzigzag(value);
+    
+    if (!(read = getVarint(in + length, size - length, value))) {
+        return 0;
+    }
+    length += read;
+    int32_t temperature = this->lastTemperature + (int32_t)unzigzag(value);
+    
+    // Only commit the state once the whole sample has been read
+    this->resolution = resolution;
+    this->lastTimestamp = timestamp;
+    this->lastDelta = delta;
+    this->lastPressure = pressure;
+    this->lastTemperature = temperature;
+    this->count++;
+    
+    sample.timestamp = timestamp * resolution;
+    sample.rawTemperature = 0;
+    sample.rawPressure = 0;
+    sample.pressure = pressure;
+    sample.unfilteredPressure = pressure;
+    sample.temperature = temperature;
+    sample.mode = 0;
+    
+    return length;
+}
+
+/**
+ * Reads up to count samples from the stream
+ * @param consumed set to the number of bytes read. A trailing partial sample is left unread.
+ * @return the number of samples read
+ */
+size_t SampleDecoder::decode(const uint8_t *in, size_t size, bmp183_sample *samples, size_t count, size_t &consumed) {
+    size_t decoded = 0, offset = 0;
+    
+    while (decoded < count) {
+        size_t length = this->decode(in + offset, size - offset, samples[decoded]);
+        
+        if (length == 0) {
+            break;
+        }
+        
+        offset += length;
+        decoded++;
+    }
+    
+    consumed = offset;
+    
+    return decoded;
+}
@@ -0,0 +1,92 @@
+/**
+ * \file SampleCodec.h
+ *
+ *  Compact delta encoding of sample series.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __SampleCodec__
+#define __SampleCodec__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Bmp183Drv.h"
+
+/*=========================================================================
+ STREAM FORMAT
+ -----------------------------------------------------------------------
+ A stream starts with a magic byte, a version byte and the timestamp
+ resolution in microseconds as a varint. Each sample follows as three
+ zig-zag varints on the compensated integers:
+ 
+   timestamp    absolute for the first sample, a delta for the second,
+                and the change in delta after that
+   pressure     absolute for the first sample, then the delta, in Pa
+   temperature  absolute for the first sample, then the delta, in 0.01 C
+ 
+ At a steady rate a sample usually takes three or four bytes, against
+ sixteen for a capture record and about fourteen as text.
+ -----------------------------------------------------------------------*/
+static const uint8_t codecMagic = 0xB3;
+static const uint8_t codecVersion = 1;
+/*=========================================================================*/
+
+/**
+ * @class SampleEncoder
+ * @brief Compresses a series of samples into a byte stream, one sample at a time.
+ */
+class SampleEncoder {
+    
+public:
+    // The most bytes one call to encode can write, including the stream header
+    static const size_t maxEncodedSize = 2 + 5 + 10 + 5 + 5;
+    
+    SampleEncoder(int resolution = 1);
+    
+    void reset();
+    size_t encode(const bmp183_sample &sample, uint8_t *out);
+    size_t encode(const bmp183_sample *samples, size_t count, uint8_t *out, size_t size, size_t &written);
+    
+private:
+    int64_t resolution;
+    uint64_t count;
+    int64_t lastTimestamp;
+    int64_t lastDelta;
+    int32_t lastPressure;
+    int32_t lastTemperature;
+};
+
+/**
+ * @class SampleDecoder
+ * @brief Expands a stream written by SampleEncoder back into samples, one sample at a time.
+ *
+ * Decoded samples carry the timestamp, pressure and temperature. Raw values and mode are not
+ * part of the stream, and are left zero.
+ */
+class SampleDecoder {
+    
+public:
+    SampleDecoder();
+    
+    void reset();
+    size_t decode(const uint8_t *in, size_t size, bmp183_sample &sample);
+    size_t decode(const uint8_t *in, size_t size, bmp183_sample *samples, size_t count, size_t &consumed);
+    
+private:
+    int64_t resolution;
+    uint64_t count;
+    int64_t lastTimestamp;
+    int64_t lastDelta;
+    int32_t lastPressure;
+    int32_t lastTemperature;
+};
+
+#endif /* __SampleCodec__ */
@@ -0,0 +1,134 @@
+/**
+ * \file SampleFilter.cpp
+ *
+ *  Per-sample updates of the pressure filters.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+#include "SampleFilter.h"
+
+SampleFilter::SampleFilter() {
+    this->setNone();
+}
+
+/**
+ * Passes samples through unchanged
+ */
+void SampleFilter::setNone() {
+    this->type = SAMPLE_FILTER_NONE;
+    this->coefficient = 1;
+    this->processNoise = 0;
+    this->measurementNoise = 0;
+    
+    this->reset();
+}
+
+/**
+ * Selects the first order IIR filter, out = out + (in - out) / coefficient
+ * @param coefficient the filter coefficient, as on the BMP280 usually 2, 4, 8 or 16
+ * @return false if the coefficient is less than 1
+ */
+bool SampleFilter::setIIR(int coefficient) {
+    if (coefficient < 1) {
+        return false;
+    }
+    
+    this->type = SAMPLE_FILTER_IIR;
+    this->coefficient = coefficient;
+    
+    this->reset();
+    
+    return true;
+}
+
+/**
+ * Selects the scalar Kalman filter
+ * @param processNoise variance the true value drifts by per second, in units squared
+ * @param measurementNoise variance of a measurement in units squared, or zero to use the noise
+ * given with each sample
+ * @return false if either variance is negative, or the process noise is zero
+ */
+bool SampleFilter::setKalman(float processNoise, float measurementNoise) {
+    if ((processNoise <= 0) || (measurementNoise < 0)) {
+        return false;
+    }
+    
+    this->type = SAMPLE_FILTER_KALMAN;
+    this->processNoise = processNoise;
+    this->measurementNoise = measurementNoise;
+    
+    this->reset();
+    
+    return true;
+}
+
+sample_filter_t SampleFilter::getType() {
+    return this->type;
+}
+
+/**
+ * Folds a new sample into the filter.
+ * @param value the measured value
+ * @param timestamp time of the sample in microseconds
+ * @param measurementNoise variance of this measurement, used by the Kalman filter unless a
+ * fixed measurement noise was set
+ * @return the filtered value
+ */
+float SampleFilter::update(float value, int64_t timestamp, float measurementNoise) {
+    
+    if (this->type == SAMPLE_FILTER_NONE) {
+        return value;
+    }
+    
+    if (this->measurementNoise > 0) {
+        measurementNoise = this->measurementNoise;
+    }
+    
+    if (!this->primed) {
+        this->primed = true;
+        this->lastTimestamp = timestamp;
+        this->estimate = value;
+        this->variance = measurementNoise;
+        return value;
+    }
+    
+    if (this->type == SAMPLE_FILTER_IIR) {
+        this->estimate += (value - this->estimate) / this->coefficient;
+    }
+    else {
+        double elapsed = (timestamp - this->lastTimestamp) / 1000000.0;
+        
+        // Predict: the true value may have wandered since the last sample
+        if (elapsed > 0) {
+            this->variance += this->processNoise * elapsed;
+        }
+        
+        // Update: weigh the measurement against the prediction by their variances
+        double gain = this->variance / (this->variance + fmax(measurementNoise, 1e-9));
+        this->estimate += gain * (value - this->estimate);
+        this->variance *= (1 - gain);
+    }
+    
+    this->lastTimestamp = timestamp;
+    
+    return this->estimate;
+}
+
+/**
+ * Forgets the filter state, so the next sample passes through unchanged and starts afresh
+ */
+void SampleFilter::reset() {
+    this->primed = false;
+    this->lastTimestamp = 0;
+    this->estimate = 0;
+    this->variance = 0;
+}
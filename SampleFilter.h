@@ -0,0 +1,71 @@
+/**
+ * \file SampleFilter.h
+ *
+ *  IIR and Kalman filters for compensated pressure.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+#ifndef __SampleFilter__
+#define __SampleFilter__
+
+#include <stdint.h>
+#include <math.h>
+
+typedef enum
+{
+    SAMPLE_FILTER_NONE = 0,
+    SAMPLE_FILTER_IIR,
+    SAMPLE_FILTER_KALMAN
+} sample_filter_t;
+
+/**
+ * @class SampleFilter
+ * @brief Smooths a noisy series of samples in constant time per sample.
+ *
+ * The IIR filter is the first order low pass of the BMP280, where each output moves 1/coefficient
+ * of the way toward the new input. It suits a steady sampling rate. The Kalman filter tracks a
+ * random walk, with process noise given per second so that irregular intervals are handled, and
+ * with the measurement noise of each sample either fixed or supplied with the sample.
+ */
+class SampleFilter {
+
+public:
+    
+    SampleFilter();
+    
+    void setNone();
+    bool setIIR(int coefficient);
+    bool setKalman(float processNoise, float measurementNoise);
+    sample_filter_t getType();
+    float update(float value, int64_t timestamp, float measurementNoise);
+    void reset();
+    
+protected:
+    
+private:
+    
+    sample_filter_t type;
+    int coefficient;
+    
+    // Kalman noise variances, per second for the process, zero measurement noise to take it per sample
+    float processNoise;
+    float measurementNoise;
+    
+    // Filter state
+    bool primed;
+    int64_t lastTimestamp;
+    double estimate;
+    double variance;
+    
+};
+
+#endif /* __SampleFilter__ */
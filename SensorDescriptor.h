@@ -0,0 +1,141 @@
+/**
+ * \file SensorDescriptor.h
+ *
+ *  Compile-time table of sensor values, their types and typed readers.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __SensorDescriptor__
+#define __SensorDescriptor__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+namespace sensor {
+
+/**
+ * @class StrRef
+ * @brief A constexpr reference to a string literal, standing in for std::string_view under C++11.
+ */
+class StrRef {
+public:
+    template<size_t N>
+    constexpr StrRef(const char (&literal)[N]) : ptr(literal), len(N - 1) {}
+    constexpr StrRef(const char *str, size_t length) : ptr(str), len(length) {}
+    
+    constexpr const char *data() const { return ptr; }
+    constexpr size_t size() const { return len; }
+    
+    /// FNV-1a hash, evaluated at compile time for literals
+    constexpr uint32_t hash() const { return fnv1a(ptr, len, 2166136261u); }
+    
+    /// Compile-time comparison, usable in constant expressions
+    constexpr bool equals(StrRef other) const {
+        return (len == other.len) && matches(ptr, other.ptr, len);
+    }
+    
+    /// Run-time hash, computed iteratively so arbitrary input is safe to hash
+    uint32_t runtimeHash() const {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ (uint8_t)ptr[i]) * 16777619u;
+        }
+        return hash;
+    }
+    
+    /// Run-time comparison
+    bool operator==(StrRef other) const {
+        return (len == other.len) && (memcmp(ptr, other.ptr, len) == 0);
+    }
+    
+    std::string str() const { return std::string(ptr, len); }
+    
+private:
+    static constexpr uint32_t fnv1a(const char *str, size_t length, uint32_t hash) {
+        return (length == 0) ? hash : fnv1a(str + 1, length - 1, (hash ^ (uint8_t)*str) * 16777619u);
+    }
+    
+    static constexpr bool matches(const char *a, const char *b, size_t length) {
+        return (length == 0) || ((*a == *b) && matches(a + 1, b + 1, length - 1));
+    }
+    
+    const char *ptr;
+    size_t len;
+};
+
+/**
+ * @class ValueDescriptor
+ * @brief Name, type and typed reader of one value sensed by a Device. The hash of the name is
+ * computed when the descriptor is constructed, which is at compile time for a constexpr descriptor.
+ */
+template<class Device>
+struct ValueDescriptor {
+    typedef float (Device::*Reader)();
+    
+    constexpr ValueDescriptor(StrRef valueName, StrRef valueType, Reader valueReader)
+        : name(valueName), type(valueType), reader(valueReader), hash(valueName.hash()) {}
+    
+    StrRef name;
+    StrRef type;
+    Reader reader;
+    uint32_t hash;
+};
+
+/**
+ * @class SensorDescriptor
+ * @brief Compile-time description of a sensor device and the N values it senses.
+ *
+ * Declared constexpr by a driver, all of its metadata lives in read-only data with no static
+ * initialization, names resolve to indices at compile time through indexOf(), and run-time
+ * lookups compare precomputed hashes without building any strings.
+ */
+template<class Device, size_t N>
+struct SensorDescriptor {
+    StrRef name;
+    StrRef type;
+    StrRef version;
+    ValueDescriptor<Device> values[N];
+    
+    constexpr size_t numValues() const { return N; }
+    
+    constexpr bool contains(int index) const {
+        return (index >= 0) && ((size_t)index < N);
+    }
+    
+    /// Index of the named value, or -1 if there is none. Resolves at compile time for literals.
+    constexpr int indexOf(StrRef valueName, size_t from = 0) const {
+        return (from == N) ? -1 : (values[from].name.equals(valueName) ? (int)from : indexOf(valueName, from + 1));
+    }
+    
+    /// Run-time lookup of the named value, or -1 if there is none
+    int find(StrRef valueName) const {
+        uint32_t hash = valueName.runtimeHash();
+        
+        for (size_t i = 0; i < N; i++) {
+            if ((values[i].hash == hash) && (values[i].name == valueName)) {
+                return (int)i;
+            }
+        }
+        
+        return -1;
+    }
+    
+    /// Reads the value at index from the device through its typed reader
+    float read(Device &device, int index) const {
+        return (device.*(values[index].reader))();
+    }
+};
+
+} /* namespace sensor */
+
+#endif /* __SensorDescriptor__ */
@@ -0,0 +1,109 @@
+/**
+ * \file SeqLock.h
+ *
+ *  Sequence lock for lock-free reads of small, rarely written snapshots.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __SeqLock__
+#define __SeqLock__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+/**
+ * @class SeqLock
+ * @brief Holds a small, trivially copyable value that many threads read and few threads replace.
+ *
+ * A reader copies the value and retries if a writer was at work meanwhile, so it never locks or
+ * waits on a lock, and every copy it returns is one consistent whole. Writers are serialized by a
+ * mutex among themselves only. The value is held as atomic words, so the copy is well defined.
+ */
+template <typename T>
+class SeqLock {
+    
+public:
+    
+    SeqLock() : sequence(0) {
+        this->write(T());
+    }
+    
+    /**
+     * @return a consistent copy of the value
+     */
+    T load() const {
+        uint32_t copy[numWords];
+        uint32_t before;
+        
+        do {
+            before = this->sequence.load(std::memory_order_acquire);
+            
+            for (size_t i = 0; i < numWords; i++) {
+                copy[i] = this->words[i].load(std::memory_order_relaxed);
+            }
+            
+            std::atomic_thread_fence(std::memory_order_acquire);
+            
+        } while ((before & 1) || (this->sequence.load(std::memory_order_relaxed) != before));
+        
+        T value;
+        memcpy(&value, copy, sizeof(T));
+        
+        return value;
+    }
+    
+    void store(const T &value) {
+        std::lock_guard<std::mutex> lock(this->writeMutex);
+        this->write(value);
+    }
+    
+    /**
+     * Changes the value in place, so that concurrent updates of different fields are all kept
+     * @param modify called with a copy of the value to change, which is then published
+     */
+    template <typename Modify>
+    void update(Modify modify) {
+        std::lock_guard<std::mutex> lock(this->writeMutex);
+        
+        T value = this->load();
+        modify(value);
+        this->write(value);
+    }
+    
+private:
+    
+    static const size_t numWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    
+    // An odd sequence marks a write under way
+    void write(const T &value) {
+        uint32_t copy[numWords] = {0};
+        memcpy(copy, &value, sizeof(T));
+        
+        uint32_t start = this->sequence.load(std::memory_order_relaxed);
+        this->sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        
+        for (size_t i = 0; i < numWords; i++) {
+            this->words[i].store(copy[i], std::memory_order_relaxed);
+        }
+        
+        this->sequence.store(start + 2, std::memory_order_release);
+    }
+    
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> words[numWords];
+    std::mutex writeMutex;
+    
+};
+
+#endif /* __SeqLock__ */
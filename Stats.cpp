@@ -0,0 +1,118 @@
+/**
+ * \file Stats.cpp
+ *
+ *  Power-of-two latency histograms and the global statistics switch.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Stats.h"
+
+namespace stats {
+
+    static std::atomic<bool> enabled(false);
+    
+    bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    
+    void setEnabled(bool enable) {
+        enabled.store(enable, std::memory_order_relaxed);
+    }
+    
+    Histogram::Histogram() {
+        this->reset();
+    }
+    
+    void Histogram::record(uint64_t microseconds) {
+        int bucket = 0;
+        
+        // The bucket is one more than the index of the highest set bit
+        while ((bucket < numBuckets - 1) && (microseconds >> bucket)) {
+            bucket++;
+        }
+        
+        this->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        this->count.fetch_add(1, std::memory_order_relaxed);
+        this->sum.fetch_add(microseconds, std::memory_order_relaxed);
+        
+        uint64_t previous = this->max.load(std::memory_order_relaxed);
+        while ((microseconds > previous) && !this->max.compare_exchange_weak(previous, microseconds, std::memory_order_relaxed)) {
+        }
+    }
+    
+    void Histogram::reset() {
+        for (int i = 0; i < numBuckets; i++) {
+            this->buckets[i].store(0, std::memory_order_relaxed);
+        }
+        
+        this->count.store(0, std::memory_order_relaxed);
+        this->sum.store(0, std::memory_order_relaxed);
+        this->max.store(0, std::memory_order_relaxed);
+    }
+    
+    uint64_t Histogram::getCount() const {
+        return this->count.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t Histogram::getSum() const {
+        return this->sum.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t Histogram::getMax() const {
+        return this->max.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t Histogram::getBucket(int bucket) const {
+        if ((bucket < 0) || (bucket >= numBuckets)) {
+            return 0;
+        }
+        
+        return this->buckets[bucket].load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @return the exclusive upper limit of a bucket in microseconds, or 0 for the unbounded last bucket
+     */
+    uint64_t Histogram::getBucketLimit(int bucket) {
+        if ((bucket < 0) || (bucket >= numBuckets - 1)) {
+            return 0;
+        }
+        
+        return (uint64_t)1 << bucket;
+    }
+    
+    /**
+     * Estimates a percentile as the upper limit of the bucket containing it, capped by the maximum.
+     * @param fraction the percentile as a fraction, such as 0.99
+     */
+    uint64_t Histogram::getPercentile(double fraction) const {
+        uint64_t total = this->getCount();
+        
+        if (total == 0) {
+            return 0;
+        }
+        
+        uint64_t target = (uint64_t)(fraction * total);
+        uint64_t seen = 0;
+        uint64_t highest = this->getMax();
+        
+        for (int i = 0; i < numBuckets - 1; i++) {
+            seen += this->getBucket(i);
+            if (seen > target) {
+                uint64_t limit = getBucketLimit(i);
+                return (limit < highest) ? limit : highest;
+            }
+        }
+        
+        return highest;
+    }
+
+} /* namespace stats */
@@ -0,0 +1,88 @@
+/**
+ * \file Stats.h
+ *
+ *  Opt-in counters and latency histograms for the driver hot paths.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __Stats__
+#define __Stats__
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+namespace stats {
+
+/**
+ * Statistics are collected only while enabled. When disabled, each instrumented site costs a
+ * single relaxed load of this flag, and no clock is read.
+ */
+bool isEnabled();
+void setEnabled(bool enable);
+
+/**
+ * @class Histogram
+ * @brief Lock-free latency histogram with fixed power-of-two buckets in microseconds.
+ *
+ * Bucket 0 counts latencies under 1us, bucket i counts latencies from 2^(i-1) up to 2^i us, and
+ * the last bucket counts everything longer. Recording is a few relaxed atomic adds.
+ */
+class Histogram {
+public:
+    static const int numBuckets = 24;
+    
+    Histogram();
+    
+    void record(uint64_t microseconds);
+    void reset();
+    
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMax() const;
+    uint64_t getBucket(int bucket) const;
+    uint64_t getPercentile(double fraction) const;
+    static uint64_t getBucketLimit(int bucket);
+    
+private:
+    std::atomic<uint64_t> buckets[numBuckets];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the time spent in a scope into a histogram, if statistics are enabled on entry.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &target) : histogram(target), active(isEnabled()) {
+        if (active) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    
+    ~ScopedTimer() {
+        if (active) {
+            histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    
+private:
+    Histogram &histogram;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+} /* namespace stats */
+
+#endif /* __Stats__ */
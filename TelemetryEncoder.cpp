@@ -0,0 +1,223 @@
+/**
+ * \file TelemetryEncoder.cpp
+ *
+ *  Escaping and zero-copy rendering of telemetry lines and records.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "TelemetryEncoder.h"
+
+// Longest rendering of the line protocol fields and timestamp, which follow the prefix
+static const size_t maxLineFields = sizeof(" pressure=-21474836.48,temperature=-21474836.48 -9223372036854775808000\n");
+
+// Length prefix and record of a binary sample
+static const size_t binaryRecordSize = sizeof(uint16_t) + sizeof(bmp183_telemetry_record);
+
+/*=========================================================================
+ FORMATTING
+ -----------------------------------------------------------------------*/
+static inline size_t putUnsigned(uint64_t value, char *out) {
+    char digits[20];
+    size_t length = 0;
+    
+    do {
+        digits[length++] = '0' + (char)(value % 10);
+        value /= 10;
+    } while (value != 0);
+    
+    for (size_t i = 0; i < length; i++) {
+        out[i] = digits[length - 1 - i];
+    }
+    
+    return length;
+}
+
+static inline size_t putSigned(int64_t value, char *out) {
+    if (value < 0) {
+        out[0] = '-';
+        return 1 + putUnsigned(0 - (uint64_t)value, out + 1);
+    }
+    
+    return putUnsigned(value, out);
+}
+
+// Writes a value held in hundredths with two decimal places, as 1013.25 for 101325
+static inline size_t putHundredths(int32_t value, char *out) {
+    size_t length = 0;
+    uint32_t magnitude = (value < 0) ? 0 - (uint32_t)value : (uint32_t)value;
+    
+    if (value < 0) {
+        out[length++] = '-';
+    }
+    
+    length += putUnsigned(magnitude / 100, out + length);
+    out[length++] = '.';
+    out[length++] = '0' + (char)((magnitude / 10) % 10);
+    out[length++] = '0' + (char)(magnitude % 10);
+    
+    return length;
+}
+
+static inline size_t putText(const char *text, size_t length, char *out) {
+    memcpy(out, text, length);
+    return length;
+}
+
+// Escapes the characters line protocol treats as delimiters
+static std::string escape(const std::string &text, const char *special) {
+    std::string escaped;
+    
+    for (size_t i = 0; i < text.size(); i++) {
+        if (strchr(special, text[i])) {
+            escaped += '\\';
+        }
+        escaped += text[i];
+    }
+    
+    return escaped;
+}
+/*=========================================================================*/
+
+TelemetryEncoder::TelemetryEncoder() {
+    this->format = LINE_PROTOCOL;
+    this->measurement = "bmp183";
+    this->render();
+}
+
+void TelemetryEncoder::setFormat(FORMAT format) {
+    this->format = format;
+}
+
+TelemetryEncoder::FORMAT TelemetryEncoder::getFormat() {
+    return this->format;
+}
+
+/**
+ * Sets the line protocol measurement name
+ * @return false if the name is empty
+ */
+bool TelemetryEncoder::setMeasurement(std::string measurement) {
+    if (measurement.empty()) {
+        return false;
+    }
+    
+    this->measurement = escape(measurement, ", ");
+    this->render();
+    
+    return true;
+}
+
+/**
+ * Adds a tag sent with every sample in line protocol, and once per batch in binary
+ * @return false if the key or value is empty, which line protocol does not allow, or the tags
+ * would outgrow the 16 bit length of the binary header
+ */
+bool TelemetryEncoder::addTag(std::string key, std::string value) {
+    if (key.empty() || value.empty()) {
+        return false;
+    }
+    
+    std::string tag = "," + escape(key, ",= ") + "=" + escape(value, ",= ");
+    
+    // The tags are kept with a leading comma, which the binary header leaves out
+    if (this->tags.size() + tag.size() - 1 > UINT16_MAX) {
+        return false;
+    }
+    
+    this->tags += tag;
+    this->render();
+    
+    return true;
+}
+
+void TelemetryEncoder::clearTags() {
+    this->tags.clear();
+    this->render();
+}
+
+// Renders the part of each line that is the same for every sample
+void TelemetryEncoder::render() {
+    this->prefix = this->measurement + this->tags;
+}
+
+/**
+ * @return the most bytes a batch of count samples can take, including any header
+ */
+size_t TelemetryEncoder::maxEncodedSize(size_t count) {
+    if (this->format == BINARY) {
+        return 5 + this->tags.size() + count * binaryRecordSize;
+    }
+    
+    return count * (this->prefix.size() + maxLineFields);
+}
+
+/**
+ * Starts a batch. Binary batches begin with a header carrying the tags, while line protocol
+ * needs none.
+ * @param out where to write, with room for maxEncodedSize(0) bytes
+ * @return the number of bytes written
+ */
+size_t TelemetryEncoder::begin(char *out) {
+    if (this->format != BINARY) {
+        return 0;
+    }
+    
+    // The tags are kept with a leading comma, for line protocol
+    uint16_t length = this->tags.empty() ? 0 : (uint16_t)(this->tags.size() - 1);
+    
+    out[0] = 'B';
+    out[1] = 'T';
+    out[2] = (char)telemetryVersion;
+    out[3] = (char)(length & 0xFF);
+    out[4] = (char)(length >> 8);
+    
+    if (length > 0) {
+        memcpy(out + 5, this->tags.data() + 1, length);
+    }
+    
+    return 5 + length;
+}
+
+/**
+ * Appends one sample to the batch, as a line of pressure in hPa, temperature in C and a
+ * nanosecond timestamp, or as a length prefixed binary record
+ * @param out where to write, with room for maxEncodedSize(1) bytes
+ * @return the number of bytes written
+ */
+size_t TelemetryEncoder::encode(const bmp183_sample &sample, char *out) {
+    
+    if (this->format == BINARY) {
+        bmp183_telemetry_record record;
+        record.timestamp = sample.timestamp;
+        record.pressure = sample.pressure;
+        record.temperature = sample.temperature;
+        record.mode = sample.mode;
+        
+        // All supported targets are little endian, so the record is copied as it is laid out
+        out[0] = (char)(sizeof record & 0xFF);
+        out[1] = (char)(sizeof record >> 8);
+        memcpy(out + 2, &record, sizeof record);
+        
+        return binaryRecordSize;
+    }
+    
+    size_t length = putText(this->prefix.data(), this->prefix.size(), out);
+    
+    length += putText(" pressure=", 10, out + length);
+    length += putHundredths(sample.pressure, out + length);
+    length += putText(",temperature=", 13, out + length);
+    length += putHundredths(sample.temperature, out + length);
+    out[length++] = ' ';
+    length += putSigned(sample.timestamp, out + length);
+    length += putText("000\n", 4, out + length);
+    
+    return length;
+}
@@ -0,0 +1,80 @@
+/**
+ * \file TelemetryEncoder.h
+ *
+ *  Encoding of buffered samples as InfluxDB line protocol or binary records.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __TelemetryEncoder__
+#define __TelemetryEncoder__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include "Bmp183Drv.h"
+
+/*=========================================================================
+ BINARY FORMAT
+ -----------------------------------------------------------------------
+ A batch starts with a header: the magic bytes 'B' 'T', a version byte,
+ a 16 bit tag length, and the tags as key=value pairs joined by commas.
+ Each sample follows as a 16 bit length and a record, so that readers
+ can skip fields added by later versions. All integers are little endian.
+ -----------------------------------------------------------------------*/
+static const uint8_t telemetryVersion = 1;
+
+typedef struct
+{
+    int64_t  timestamp;         // microseconds since the epoch
+    int32_t  pressure;          // Pa
+    int32_t  temperature;       // 0.01 C
+    uint8_t  mode;
+} __attribute__((packed)) bmp183_telemetry_record;
+/*=========================================================================*/
+
+/**
+ * @class TelemetryEncoder
+ * @brief Serializes samples for upstream telemetry as InfluxDB line protocol or binary records.
+ *
+ * The measurement name and tags are escaped and rendered once when set, so encoding a sample is
+ * integer formatting into the output buffer, with no allocation.
+ */
+class TelemetryEncoder {
+    
+public:
+    enum FORMAT {
+        LINE_PROTOCOL = 0,
+        BINARY = 1
+    };
+    
+    TelemetryEncoder();
+    
+    void setFormat(FORMAT format);
+    FORMAT getFormat();
+    bool setMeasurement(std::string measurement);
+    bool addTag(std::string key, std::string value);
+    void clearTags();
+    
+    size_t maxEncodedSize(size_t count);
+    size_t begin(char *out);
+    size_t encode(const bmp183_sample &sample, char *out);
+    
+private:
+    void render();
+    
+    FORMAT format;
+    std::string measurement;
+    std::string tags;
+    std::string prefix;
+};
+
+#endif /* __TelemetryEncoder__ */
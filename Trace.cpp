@@ -0,0 +1,312 @@
+/**
+ * \file Trace.cpp
+ *
+ *  Trace buffers, thread registry and JSON output.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "Trace.h"
+
+namespace trace {
+
+    typedef struct
+    {
+        const char *name;
+        const char *category;
+        const char *argName;
+        int64_t  begin;             // ns since the trace started
+        int64_t  duration;          // ns
+        int64_t  arg;
+        uint32_t tid;
+    } trace_event;
+    
+    // A buffer written by one thread at a time, and read by toJson once its spans are published
+    struct Lane {
+        std::vector<trace_event> events;
+        std::atomic<size_t> count{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint32_t> session{0};
+        bool inUse = false;
+    };
+    
+    static std::atomic<bool> enabled(false);
+    static std::atomic<uint32_t> session(0);
+    static std::atomic<size_t> capacity(defaultEventsPerThread);
+    static std::atomic<int64_t> origin(0);      // steady clock ns at the start of the trace
+    
+    // Lanes are never freed, so a thread may keep using its lane without holding the lock
+    static std::mutex registryMutex;
+    static std::vector<Lane *> lanes;
+    static std::map<uint32_t, std::string> threadNames;
+    
+    // Hands the thread's lane on when the thread exits
+    struct LaneHandle {
+        Lane *lane = 0;
+        
+        ~LaneHandle() {
+            if (lane != 0) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                lane->inUse = false;
+            }
+        }
+    };
+    
+    static thread_local LaneHandle laneHandle;
+    static thread_local uint32_t threadId = 0;
+    static thread_local const char *threadName = 0;
+    
+    static uint32_t currentThreadId() {
+        if (threadId == 0) {
+            threadId = (uint32_t)syscall(SYS_gettid);
+        }
+        
+        return threadId;
+    }
+    
+    static Lane* currentLane() {
+        if (laneHandle.lane == 0) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            
+            for (size_t i = 0; (i < lanes.size()) && (laneHandle.lane == 0); i++) {
+                if (!lanes[i]->inUse) {
+                    laneHandle.lane = lanes[i];
+                }
+            }
+            
+            if (laneHandle.lane == 0) {
+                laneHandle.lane = new Lane();
+                lanes.push_back(laneHandle.lane);
+            }
+            
+            laneHandle.lane->inUse = true;
+        }
+        
+        return laneHandle.lane;
+    }
+    
+    /**
+     * Returns the calling thread's lane, reset for the current trace. The lane is reset by its own
+     * thread, so only ever one thread writes to it.
+     */
+    static Lane* sessionLane() {
+        Lane *lane = currentLane();
+        uint32_t current = session.load(std::memory_order_acquire);
+        
+        if (lane->session.load(std::memory_order_relaxed) != current) {
+            size_t size = capacity.load(std::memory_order_relaxed);
+            
+            if (lane->events.size() != size) {
+                lane->events.assign(size, trace_event());
+            }
+            lane->count.store(0, std::memory_order_relaxed);
+            lane->dropped.store(0, std::memory_order_relaxed);
+            lane->session.store(current, std::memory_order_release);
+        }
+        
+        return lane;
+    }
+    
+    bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * Starts a new trace, discarding the spans of any earlier one
+     * @param eventsPerThread the spans each thread can hold before it drops more
+     * @return false if the capacity is zero
+     */
+    bool start(size_t eventsPerThread) {
+        if (eventsPerThread == 0) {
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(registryMutex);
+        
+        capacity.store(eventsPerThread, std::memory_order_relaxed);
+        
+        // Lanes no thread holds are sized now, so threads that take them later needn't allocate
+        for (size_t i = 0; i < lanes.size(); i++) {
+            if (!lanes[i]->inUse && (lanes[i]->events.size() != eventsPerThread)) {
+                lanes[i]->events.assign(eventsPerThread, trace_event());
+            }
+        }
+        
+        origin.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+        session.fetch_add(1, std::memory_order_release);
+        enabled.store(true, std::memory_order_release);
+        
+        return true;
+    }
+    
+    void stop() {
+        enabled.store(false, std::memory_order_relaxed);
+    }
+    
+    /**
+     * Names the calling thread's track in the trace, and prepares its lane if tracing is running,
+     * so that a thread naming itself before its work doesn't set up its lane inside a span.
+     * Repeating the same name is cheap.
+     * @param name a string literal
+     */
+    void setThreadName(const char *name) {
+        if (name != threadName) {
+            threadName = name;
+            
+            std::lock_guard<std::mutex> lock(registryMutex);
+            threadNames[currentThreadId()] = name;
+        }
+        
+        prepare();
+    }
+    
+    /**
+     * Takes and sizes the calling thread's lane for the current trace, if it hasn't been already.
+     * ScopedSpan calls this before reading the clock; code recording spans with record directly
+     * should call it before taking their begin time.
+     */
+    void prepare() {
+        if (isEnabled()) {
+            sessionLane();
+        }
+    }
+    
+    /**
+     * Appends a span to the calling thread's lane
+     */
+    void record(const char *name, const char *category, std::chrono::steady_clock::time_point begin,
+                std::chrono::steady_clock::time_point end, const char *argName, int64_t arg) {
+        if (!isEnabled()) {
+            return;
+        }
+        
+        Lane *lane = sessionLane();
+        size_t index = lane->count.load(std::memory_order_relaxed);
+        
+        if (index >= lane->events.size()) {
+            lane->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
+        trace_event &event = lane->events[index];
+        event.name = name;
+        event.category = category;
+        event.argName = argName;
+        event.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count() - origin.load(std::memory_order_relaxed);
+        event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        event.arg = arg;
+        event.tid = currentThreadId();
+        
+        lane->count.store(index + 1, std::memory_order_release);
+    }
+    
+    /**
+     * Renders the spans of the current trace as Chrome trace-event JSON, with complete events in
+     * microseconds and a name for each named thread. Safe to call while tracing runs, in which case
+     * it takes the spans recorded so far.
+     */
+    std::string toJson() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        
+        uint32_t current = session.load(std::memory_order_acquire);
+        int pid = getpid();
+        std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        char line[384];
+        bool first = true;
+        
+        for (std::map<uint32_t, std::string>::iterator it = threadNames.begin(); it != threadNames.end(); ++it) {
+            snprintf(line, sizeof line, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     first ? "" : ",", pid, it->first, it->second.c_str());
+            json += line;
+            first = false;
+        }
+        
+        for (size_t i = 0; i < lanes.size(); i++) {
+            Lane *lane = lanes[i];
+            
+            if (lane->session.load(std::memory_order_acquire) != current) {
+                continue;
+            }
+            
+            size_t count = lane->count.load(std::memory_order_acquire);
+            
+            for (size_t j = 0; j < count; j++) {
+                const trace_event &event = lane->events[j];
+                int length = snprintf(line, sizeof line, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+                                      first ? "" : ",", event.name, event.category, event.begin / 1000.0, event.duration / 1000.0, pid, event.tid);
+                
+                if ((event.argName != 0) && (length > 0) && ((size_t)length < sizeof line)) {
+                    snprintf(line + length, sizeof line - length, ",\"args\":{\"%s\":%lld}", event.argName, (long long)event.arg);
+                }
+                
+                json += line;
+                json += "}";
+                first = false;
+            }
+        }
+        
+        json += "\n]}\n";
+        
+        return json;
+    }
+    
+    /**
+     * @return false if the file could not be written
+     */
+    bool writeJson(std::string filename) {
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+        
+        if (!file) {
+            return false;
+        }
+        
+        file << toJson();
+        
+        return file.good();
+    }
+    
+    size_t getEventCount() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        
+        uint32_t current = session.load(std::memory_order_acquire);
+        size_t count = 0;
+        
+        for (size_t i = 0; i < lanes.size(); i++) {
+            if (lanes[i]->session.load(std::memory_order_acquire) == current) {
+                count += lanes[i]->count.load(std::memory_order_acquire);
+            }
+        }
+        
+        return count;
+    }
+    
+    uint64_t getDropped() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        
+        uint32_t current = session.load(std::memory_order_acquire);
+        uint64_t dropped = 0;
+        
+        for (size_t i = 0; i < lanes.size(); i++) {
+            if (lanes[i]->session.load(std::memory_order_acquire) == current) {
+                dropped += lanes[i]->dropped.load(std::memory_order_relaxed);
+            }
+        }
+        
+        return dropped;
+    }
+    
+} /* namespace trace */
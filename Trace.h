@@ -0,0 +1,87 @@
+/**
+ * \file Trace.h
+ *
+ *  Per-thread span recording for Chrome trace-event timelines.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __Trace__
+#define __Trace__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace trace {
+
+/**
+ * Tracing records spans of time into a buffer per thread, to be written out as Chrome trace-event
+ * JSON and viewed in Perfetto or chrome://tracing. While stopped, each traced site costs a single
+ * relaxed load, and no clock is read.
+ *
+ * Each thread appends only to its own buffer. A thread's buffer is taken from the registry, under
+ * its lock, and sized for the trace the first time the thread records in it, which prepare does
+ * before a span's clock starts so the setup isn't timed. From then on, recording takes no locks
+ * and allocates nothing. A buffer that fills drops further spans, which are counted, rather than
+ * overwriting earlier ones. Buffers are handed on to new threads when their thread exits, so
+ * threads that come and go don't grow memory.
+ */
+bool isEnabled();
+bool start(size_t eventsPerThread);
+void stop();
+
+void setThreadName(const char *name);
+void prepare();
+void record(const char *name, const char *category, std::chrono::steady_clock::time_point begin,
+            std::chrono::steady_clock::time_point end, const char *argName = 0, int64_t arg = 0);
+
+std::string toJson();
+bool writeJson(std::string filename);
+size_t getEventCount();
+uint64_t getDropped();
+
+static const size_t defaultEventsPerThread = 16384;
+
+/**
+ * @class ScopedSpan
+ * @brief Records the time spent in a scope as a span, if tracing is running on entry. Names are
+ * kept by pointer, so they must be string literals.
+ */
+class ScopedSpan {
+public:
+    ScopedSpan(const char *name, const char *category, const char *argName = 0, int64_t arg = 0)
+        : name(name), category(category), argName(argName), arg(arg), active(isEnabled()) {
+        if (active) {
+            prepare();
+            begin = std::chrono::steady_clock::now();
+        }
+    }
+    
+    ~ScopedSpan() {
+        if (active) {
+            record(name, category, begin, std::chrono::steady_clock::now(), argName, arg);
+        }
+    }
+    
+private:
+    const char *name;
+    const char *category;
+    const char *argName;
+    int64_t arg;
+    bool active;
+    std::chrono::steady_clock::time_point begin;
+};
+
+} /* namespace trace */
+
+#endif /* __Trace__ */
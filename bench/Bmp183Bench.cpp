@@ -0,0 +1,433 @@
+/**
+ * \file Bmp183Bench.cpp
+ *
+ *  Microbenchmarks of the driver hot paths against the emulator.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * Microbenchmarks for the per-sample hot paths of the driver. Hardware is replaced by
+ * Bmp183Emulator, so the suite runs on any build machine.
+ *
+ *   bmp183_bench [--json] [--filter=text] [--scale=factor]
+ *
+ * Each benchmark reports mean ns/op, heap allocations per op, and percentiles of the per-op
+ * time measured over batches. With --json, each result is written as one JSON object per line
+ * so that runs on different builds and targets can be compared by script.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include "../Bmp183Drv.h"
+#include "../Bmp183Array.h"
+#include "../Bmp183Emulator.h"
+#include "../Bmp183Capture.h"
+#include "../SampleCodec.h"
+#include "../TelemetryEncoder.h"
+#include "../DataManip.h"
+#include "../Stats.h"
+#include "../Trace.h"
+
+#if defined(__aarch64__)
+#  define BENCH_ARCH "arm64"
+#elif defined(__arm__)
+#  define BENCH_ARCH "arm"
+#elif defined(__x86_64__)
+#  define BENCH_ARCH "x86_64"
+#else
+#  define BENCH_ARCH "unknown"
+#endif
+
+/*=========================================================================
+ ALLOCATION COUNTING
+ -----------------------------------------------------------------------*/
+static std::atomic<uint64_t> allocations(0);
+
+// Kept out of line so the compiler sees matching malloc and free, and builds without exceptions
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        abort();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    free(p);
+}
+/*=========================================================================*/
+
+typedef struct
+{
+    std::string name;
+    uint64_t iterations;
+    double   nsPerOp;
+    double   allocsPerOp;
+    double   p50;
+    double   p90;
+    double   p99;
+    double   max;
+} bench_result;
+
+static bool jsonOutput = false;
+static const char *filter = 0;
+static double scale = 1.0;
+
+// Results are folded into this so the compiler cannot discard the work being measured
+static volatile int64_t sink;
+
+/**
+ * Times op over the given number of iterations, in batches so that the clock is read rarely
+ * relative to fast operations. Percentiles are of the mean time per op within each batch.
+ */
+template<class Op>
+static void run(const char *name, uint64_t iterations, uint64_t batch, Op op) {
+    if (filter && !strstr(name, filter)) {
+        return;
+    }
+    
+    iterations = (uint64_t)(iterations * scale);
+    if (iterations < batch) {
+        iterations = batch;
+    }
+    
+    uint64_t batches = iterations / batch;
+    std::vector<double> times;
+    times.reserve(batches);
+    
+    // Warm up caches and branch predictors
+    for (uint64_t i = 0; i < batch; i++) {
+        op(i);
+    }
+    
+    uint64_t allocated = 0;
+    double total = 0;
+    
+    for (uint64_t b = 0; b < batches; b++) {
+        uint64_t before = allocations.load(std::memory_order_relaxed);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        
+        for (uint64_t i = 0; i < batch; i++) {
+            op(b * batch + i);
+        }
+        
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        allocated += allocations.load(std::memory_order_relaxed) - before;
+        total += ns;
+        times.push_back(ns / batch);
+    }
+    
+    std::sort(times.begin(), times.end());
+    
+    bench_result result;
+    result.name = name;
+    result.iterations = batches * batch;
+    result.nsPerOp = total / result.iterations;
+    result.allocsPerOp = (double)allocated / result.iterations;
+    result.p50 = times[(size_t)(0.50 * (times.size() - 1))];
+    result.p90 = times[(size_t)(0.90 * (times.size() - 1))];
+    result.p99 = times[(size_t)(0.99 * (times.size() - 1))];
+    result.max = times.back();
+    
+    if (jsonOutput) {
+        printf("{\"suite\":\"bmp183\",\"arch\":\"%s\",\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,"
+               "\"allocs_per_op\":%.3f,\"p50_ns\":%.2f,\"p90_ns\":%.2f,\"p99_ns\":%.2f,\"max_ns\":%.2f}\n",
+               BENCH_ARCH, result.name.c_str(), (unsigned long long)result.iterations, result.nsPerOp,
+               result.allocsPerOp, result.p50, result.p90, result.p99, result.max);
+    }
+    else {
+        printf("%-40s %10llu %14.1f %10.3f %12.1f %12.1f %12.1f\n",
+               result.name.c_str(), (unsigned long long)result.iterations, result.nsPerOp,
+               result.allocsPerOp, result.p50, result.p90, result.p99);
+    }
+    
+    fflush(stdout);
+}
+
+/**
+ * Reports a single measured figure, such as a compression ratio, alongside the timings
+ */
+static void note(const char *name, const char *metric, double value) {
+    if (filter && !strstr(name, filter)) {
+        return;
+    }
+    
+    if (jsonOutput) {
+        printf("{\"suite\":\"bmp183\",\"arch\":\"%s\",\"name\":\"%s\",\"%s\":%.3f}\n", BENCH_ARCH, name, metric, value);
+    }
+    else {
+        printf("%-40s %s %.3f\n", name, metric, value);
+    }
+    
+    fflush(stdout);
+}
+
+/**
+ * Builds a day of samples at 10 Hz resembling a real station: a semidiurnal pressure tide with a
+ * passing front, a diurnal temperature swing, sensor noise at ultra high resolution, and
+ * scheduling jitter on the timestamps.
+ */
+static std::vector<bmp183_sample> pressureTrace() {
+    std::vector<bmp183_sample> trace(864000);
+    std::mt19937 random(183);
+    std::normal_distribution<double> gaussian(0, 1);
+    int64_t timestamp = 1792300000000000LL;
+    
+    for (size_t i = 0; i < trace.size(); i++) {
+        double hours = i / 36000.0;
+        double front = -300 / (1 + exp(-(hours - 14) * 1.5));
+        
+        timestamp += 100000 + (int64_t)(gaussian(random) * 250);
+        trace[i].timestamp = timestamp;
+        trace[i].pressure = (int32_t)lround(101325 + 120 * sin(2 * M_PI * hours / 12) + front + 3 * gaussian(random));
+        trace[i].temperature = (int32_t)lround(1500 + 600 * sin(2 * M_PI * (hours - 9) / 24) + 2 * gaussian(random));
+        trace[i].rawTemperature = 0;
+        trace[i].rawPressure = 0;
+        trace[i].mode = BMP183_MODE_ULTRAHIGHRES;
+    }
+    
+    return trace;
+}
+
+int main(int argc, char *argv[]) {
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            jsonOutput = true;
+        }
+        else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--scale=", 8) == 0) {
+            scale = atof(argv[i] + 8);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--json] [--filter=text] [--scale=factor]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (!jsonOutput) {
+        printf("%-40s %10s %14s %10s %12s %12s %12s\n", "benchmark (" BENCH_ARCH ")", "iterations", "ns/op", "allocs/op", "p50 ns", "p90 ns", "p99 ns");
+    }
+    
+    // Datasheet example calibration, as programmed into the emulator
+    const bmp183_calib_data coeffs = { 408, -72, -14383, 32741, 32757, 23153, 6190, 4, -32768, -8711, 2868 };
+    
+    run("compensate", 2000000, 1000, [&](uint64_t i) {
+        bmp183_sample sample;
+        sample.rawTemperature = 27898 + (int32_t)(i & 63);
+        sample.rawPressure = 23843 + (int32_t)(i & 255);
+        sample.mode = BMP183_MODE_ULTRALOWPOWER;
+        Bmp183Drv::compensate(coeffs, sample);
+        sink += sample.pressure + sample.temperature;
+    });
+    
+    SampleFilter kalman;
+    kalman.setKalman(1, 0);
+    run("SampleFilter::update (kalman)", 2000000, 1000, [&](uint64_t i) {
+        sink += (int64_t)kalman.update(101325.0F + (int32_t)(i & 15), (int64_t)i * 100000, 36.0F);
+    });
+    
+    SeqLock<bmp183_config> config;
+    run("SeqLock::load (config)", 4000000, 1000, [&](uint64_t i) {
+        sink += config.load().stationAltitude;
+    });
+    
+    run("trace::ScopedSpan (disabled)", 4000000, 1000, [&](uint64_t i) {
+        trace::ScopedSpan span("bench", "bench", "i", (int64_t)i);
+        sink += i;
+    });
+    
+    trace::start(1024);
+    run("trace::ScopedSpan (enabled)", 4000000, 1000, [&](uint64_t i) {
+        trace::ScopedSpan span("bench", "bench", "i", (int64_t)i);
+        sink += i;
+    });
+    trace::stop();
+    
+    bmp183_member_sample members[4];
+    bmp183_fused_sample fused;
+    memset(members, 0, sizeof members);
+    run("Bmp183Array::fuse (4 sensors)", 2000000, 1000, [&](uint64_t i) {
+        for (int m = 0; m < 4; m++) {
+            members[m].sample.pressure = 101325 + (int32_t)((i * (m + 3)) & 15) + ((m == 3) ? 500 : 0);
+            members[m].status = BMP183_MEMBER_FUSED;
+        }
+        Bmp183Array::fuse(BMP183_FUSION_MEDIAN, 100, 4, members, fused);
+        sink += fused.pressure;
+    });
+    
+    run("seaLevelPressure", 2000000, 1000, [&](uint64_t i) {
+        sink += (int64_t)Bmp183Drv::seaLevelPressure(900.0F + (i & 127) * 0.1F, 1000);
+    });
+    
+    run("DataManip::dataToString", 1000000, 1000, [&](uint64_t i) {
+        sink += DataManip::dataToString(1000.0F + (i & 1023) * 0.07F, 1).size();
+    });
+    
+    {
+        Bmp183Emulator emulator;
+        emulator.setTimeScale(0);
+        
+        stats::setEnabled(false);
+        run("SPIDevice::transfer (emulated)", 1000000, 1000, [&](uint64_t i) {
+            sink += emulator.readRegister(0xAA + (i & 15));
+        });
+        
+        stats::setEnabled(true);
+        run("SPIDevice::transfer (emulated, stats)", 1000000, 1000, [&](uint64_t i) {
+            sink += emulator.readRegister(0xAA + (i & 15));
+        });
+        stats::setEnabled(false);
+    }
+    
+    {
+        Bmp183Emulator *emulator = new Bmp183Emulator();
+        emulator->setTimeScale(0);
+        Bmp183Drv driver(emulator, 0, BMP183_MODE_ULTRAHIGHRES);
+        
+        // Values served from a ready read-ahead sample: dispatch, sea level, range check and formatting
+        driver.setReadAhead(60000);
+        driver.getValueAtIndex(0);
+        run("getValueAtIndex (ready sample)", 200000, 100, [&](uint64_t i) {
+            sink += driver.getValueAtIndex(i & 1).size();
+        });
+        driver.setReadAhead(0);
+        
+        // A full on-demand conversion, dominated by the conversion waits
+        run("getValueAtIndex (conversion)", 40, 1, [&](uint64_t i) {
+            sink += driver.getValueAtIndex(0).size();
+        });
+    }
+    
+    {
+        std::vector<bmp183_sample> trace = pressureTrace();
+        std::vector<uint8_t> encoded(trace.size() * SampleEncoder::maxEncodedSize);
+        size_t length = 0;
+        
+        SampleEncoder encoder;
+        run("SampleEncoder::encode", 4000000, 1000, [&](uint64_t i) {
+            size_t index = i % trace.size();
+            if (index == 0) {
+                encoder.reset();
+                length = 0;
+            }
+            length += encoder.encode(trace[index], &encoded[length]);
+        });
+        
+        encoder.reset();
+        length = 0;
+        for (size_t i = 0; i < trace.size(); i++) {
+            length += encoder.encode(trace[i], &encoded[length]);
+        }
+        
+        SampleDecoder decoder;
+        size_t offset = 0;
+        run("SampleDecoder::decode", 4000000, 1000, [&](uint64_t i) {
+            if (offset >= length) {
+                decoder.reset();
+                offset = 0;
+            }
+            bmp183_sample sample;
+            offset += decoder.decode(&encoded[offset], length - offset, sample);
+            sink += sample.pressure;
+        });
+        
+        // Sizes per sample of the same day as text, as a capture record, and compressed
+        size_t text = 0;
+        for (size_t i = 0; i < trace.size(); i += 100) {
+            text += DataManip::dataToString(trace[i].pressure / 100.0F, 2).size() + DataManip::dataToString(trace[i].temperature / 100.0F, 2).size() + 2;
+        }
+        
+        SampleEncoder milliseconds(1000);
+        size_t coarse = 0;
+        for (size_t i = 0; i < trace.size(); i++) {
+            coarse += milliseconds.encode(trace[i], &encoded[0]);
+        }
+        
+        note("SampleCodec bytes/sample (text)", "bytes", (double)text / (trace.size() / 100));
+        note("SampleCodec bytes/sample (capture)", "bytes", sizeof(bmp183_capture_record));
+        note("SampleCodec bytes/sample (us)", "bytes", (double)length / trace.size());
+        note("SampleCodec bytes/sample (ms)", "bytes", (double)coarse / trace.size());
+    }
+    
+    {
+        std::vector<bmp183_sample> trace = pressureTrace();
+        TelemetryEncoder telemetry;
+        telemetry.addTag("station", "roof");
+        std::vector<char> encoded(telemetry.maxEncodedSize(1000));
+        size_t length = 0;
+        
+        run("TelemetryEncoder::encode (line)", 2000000, 1000, [&](uint64_t i) {
+            if (i % 1000 == 0) {
+                length = 0;
+            }
+            length += telemetry.encode(trace[i % trace.size()], &encoded[length]);
+        });
+        
+        telemetry.setFormat(TelemetryEncoder::BINARY);
+        run("TelemetryEncoder::encode (binary)", 4000000, 1000, [&](uint64_t i) {
+            if (i % 1000 == 0) {
+                length = 0;
+            }
+            length += telemetry.encode(trace[i % trace.size()], &encoded[length]);
+        });
+        sink += length;
+    }
+    
+    // A day of samples at 10 Hz, replayed from a memory mapped capture
+    const char *replayName = "Bmp183Replay::replay (day at 10 Hz)";
+    if (!filter || strstr(replayName, filter)) {
+        char path[] = "/tmp/bmp183_bench_XXXXXX";
+        int fd = mkstemp(path);
+        
+        if (fd >= 0) {
+            close(fd);
+            unlink(path);
+            
+            Bmp183Recorder recorder;
+            recorder.open(path, coeffs);
+            
+            bmp183_sample sample;
+            for (int64_t i = 0; i < 864000; i++) {
+                sample.timestamp = i * 100000;
+                sample.rawTemperature = 27898 + (int32_t)(i & 63);
+                sample.rawPressure = 23843 + (int32_t)(i & 255);
+                sample.mode = BMP183_MODE_ULTRALOWPOWER;
+                recorder.record(sample);
+            }
+            recorder.close();
+            
+            Bmp183Replay replay;
+            if (replay.open(path)) {
+                run(replayName, 10, 1, [&](uint64_t i) {
+                    replay.replay([&](const bmp183_sample &replayed) {
+                        sink += replayed.pressure;
+                        return true;
+                    });
+                });
+            }
+            unlink(path);
+        }
+    }
+    
+    return 0;
+}
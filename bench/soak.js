@@ -0,0 +1,254 @@
+/**
+ * \file soak.js
+ *
+ *  Soak test of the Node binding under sustained load.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Load test of the Bmp183 binding, measuring its impact on the rest of the process:
+ *  event loop lag, threadpool queue delay, heap growth and achieved sample throughput, and
+ *  how long the constructor and any synchronous reads block the main thread.
+ *  Runs against the emulator unless a device is given.
+ *
+ *    node bench/soak.js [--duration=60] [--concurrency=4] [--rate=0] [--sync=0]
+ *                       [--device=emulator] [--mode=3] [--interval=5] [--json]
+ *
+ *  --concurrency  asynchronous requests kept in flight when --rate is 0 (closed loop)
+ *  --rate         requests issued per second regardless of completions (open loop)
+ *  --sync         fraction of requests made with valueAtIndexSync on the main thread
+ *  --interval     seconds between progress reports
+ *
+ *  Run node with --expose-gc to have heap figures taken after a full collection.
+ */
+
+'use strict';
+
+const path = require('path');
+const addon = require(path.join(__dirname, '..', 'build', 'Release', 'bmp183'));
+
+const options = {
+    duration: 60,
+    concurrency: 4,
+    rate: 0,
+    sync: 0,
+    device: 'emulator',
+    mode: 3,
+    interval: 5,
+    json: false
+};
+
+process.argv.slice(2).forEach((arg) => {
+    const match = /^--([a-z]+)(?:=(.*))?$/.exec(arg);
+    if (!match || !(match[1] in options)) {
+        console.error(`Unknown option ${arg}`);
+        process.exit(1);
+    }
+    options[match[1]] = (typeof options[match[1]] === 'number') ? Number(match[2]) :
+                        (typeof options[match[1]] === 'boolean') ? true : match[2];
+});
+
+// The constructor takes a full conversion on the main thread, so it is timed with the sync reads
+const constructStart = process.hrtime();
+const bmp183 = new addon.Bmp183(options.device, 0, options.mode);
+const constructTime = hrtimeMillis(process.hrtime(constructStart));
+
+if (!bmp183.deviceActive()) {
+    console.error(`${options.device} is not active`);
+    process.exit(1);
+}
+
+bmp183.statsEnabled(true);
+bmp183.resetStats();
+
+/*
+ * Event loop lag: a timer that should fire every lagResolution ms records how late it runs.
+ */
+const lagResolution = 10;
+let lags = [];
+let lagExpected = process.hrtime();
+
+function hrtimeMillis(t) {
+    return t[0] * 1e3 + t[1] / 1e6;
+}
+
+const lagTimer = setInterval(() => {
+    const now = process.hrtime();
+    const late = hrtimeMillis(now) - hrtimeMillis(lagExpected) - lagResolution;
+    lags.push(Math.max(0, late));
+    lagExpected = now;
+}, lagResolution);
+
+function percentile(sorted, fraction) {
+    if (sorted.length === 0) {
+        return 0;
+    }
+    return sorted[Math.min(sorted.length - 1, Math.floor(fraction * sorted.length))];
+}
+
+function heapUsed() {
+    if (global.gc) {
+        global.gc();
+    }
+    return process.memoryUsage().heapUsed;
+}
+
+/*
+ * Load generation
+ */
+let issued = 0;
+let completed = 0;
+let invalid = 0;
+let inFlight = 0;
+let maxInFlight = 0;
+let syncTime = 0;
+let running = true;
+
+function issue() {
+    const index = issued++ % 2;
+
+    if (Math.random() < options.sync) {
+        const start = process.hrtime();
+        const value = bmp183.valueAtIndexSync(index);
+        syncTime += hrtimeMillis(process.hrtime(start));
+        completed++;
+        if (value === 'none') {
+            invalid++;
+        }
+        if (running && (options.rate === 0)) {
+            setImmediate(issue);
+        }
+        return;
+    }
+
+    inFlight++;
+    maxInFlight = Math.max(maxInFlight, inFlight);
+
+    bmp183.valueAtIndex(index, (err, value) => {
+        inFlight--;
+        completed++;
+        if (err || (value === 'none')) {
+            invalid++;
+        }
+        if (running && (options.rate === 0)) {
+            issue();
+        }
+    });
+}
+
+let rateTimer = null;
+
+if (options.rate > 0) {
+    // Issue in ticks of at most 10ms, carrying fractional requests over
+    const tick = Math.max(1, Math.min(10, 1000 / options.rate));
+    let owed = 0;
+    rateTimer = setInterval(() => {
+        owed += options.rate * tick / 1000;
+        while (owed >= 1) {
+            owed--;
+            issue();
+        }
+    }, tick);
+}
+else {
+    for (let i = 0; i < options.concurrency; i++) {
+        issue();
+    }
+}
+
+/*
+ * Reporting
+ */
+const startTime = process.hrtime();
+const startHeap = heapUsed();
+let lastCompleted = 0;
+let reports = [];
+
+function snapshot() {
+    const elapsed = hrtimeMillis(process.hrtime(startTime)) / 1000;
+    const sortedLags = lags.slice().sort((a, b) => a - b);
+    const stats = bmp183.stats();
+    const report = {
+        elapsed: elapsed,
+        completed: completed,
+        throughput: (completed - lastCompleted) / options.interval,
+        invalid: invalid,
+        inFlight: inFlight,
+        maxInFlight: maxInFlight,
+        lagP50: percentile(sortedLags, 0.50),
+        lagP99: percentile(sortedLags, 0.99),
+        lagMax: percentile(sortedLags, 1),
+        queueDelayP50: stats.queueDelay.p50 / 1000,
+        queueDelayP99: stats.queueDelay.p99 / 1000,
+        heapUsed: process.memoryUsage().heapUsed,
+        rss: process.memoryUsage().rss
+    };
+    lastCompleted = completed;
+    return report;
+}
+
+const reportTimer = setInterval(() => {
+    const report = snapshot();
+    reports.push(report);
+    lags = [];
+    if (!options.json) {
+        console.log(`${report.elapsed.toFixed(0)}s: ${report.throughput.toFixed(1)} samples/s, ` +
+                    `lag p50/p99/max ${report.lagP50.toFixed(2)}/${report.lagP99.toFixed(2)}/${report.lagMax.toFixed(2)} ms, ` +
+                    `queue p99 ${report.queueDelayP99.toFixed(2)} ms, in flight ${report.inFlight}, ` +
+                    `heap ${(report.heapUsed / 1048576).toFixed(1)} MB`);
+    }
+}, options.interval * 1000);
+
+setTimeout(() => {
+    running = false;
+    clearInterval(reportTimer);
+    if (rateTimer) {
+        clearInterval(rateTimer);
+    }
+
+    // Let outstanding requests drain before the final figures
+    const drain = setInterval(() => {
+        if (inFlight > 0) {
+            return;
+        }
+        clearInterval(drain);
+        clearInterval(lagTimer);
+
+        const elapsed = hrtimeMillis(process.hrtime(startTime)) / 1000;
+        const stats = bmp183.stats();
+        const endHeap = heapUsed();
+        const allLags = [];
+        reports.forEach((r) => allLags.push(r.lagP99));
+
+        const summary = {
+            options: options,
+            elapsed: elapsed,
+            completed: completed,
+            invalid: invalid,
+            throughput: completed / elapsed,
+            maxInFlight: maxInFlight,
+            syncBlockedMs: syncTime,
+            constructorBlockedMs: constructTime,
+            lagP99Worst: allLags.length ? Math.max.apply(null, allLags) : 0,
+            queueDelay: stats.queueDelay,
+            work: stats.work,
+            completionDelay: stats.completionDelay,
+            heapStart: startHeap,
+            heapEnd: endHeap,
+            heapGrowth: endHeap - startHeap,
+            reports: reports
+        };
+
+        if (options.json) {
+            console.log(JSON.stringify(summary));
+        }
+        else {
+            console.log(`Completed ${completed} samples in ${elapsed.toFixed(1)}s (${summary.throughput.toFixed(1)}/s), ` +
+                        `${invalid} invalid, max ${maxInFlight} in flight`);
+            console.log(`Worst event loop lag p99 ${summary.lagP99Worst.toFixed(2)} ms, ` +
+                        `main thread blocked ${syncTime.toFixed(0)} ms in sync reads ` +
+                        `and ${constructTime.toFixed(1)} ms in the constructor`);
+            console.log(`Threadpool queue delay p50/p99 ${(stats.queueDelay.p50 / 1000).toFixed(2)}/${(stats.queueDelay.p99 / 1000).toFixed(2)} ms, ` +
+                        `callback delay p99 ${(stats.completionDelay.p99 / 1000).toFixed(2)} ms`);
+            console.log(`Heap grew ${(summary.heapGrowth / 1024).toFixed(1)} KB`);
+        }
+    }, 10);
+}, options.duration * 1000);
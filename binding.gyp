@@ -1,10 +1,52 @@
 {
+    "variables": {
+        "build_tools%": 0,
+    },
     "targets": [
+        {
+            "target_name": "bmp183_driver",
+            "type": "static_library",
+            "sources": [ "Stats.cpp", "Trace.cpp", "BusDevice.cpp", "SPIDevice.cpp", "I2CDevice.cpp", "DataManip.cpp", "SampleCadence.cpp", "SampleFilter.cpp", "Bmp183Emulator.cpp", "Bmp183Capture.cpp", "HistoryStore.cpp", "SampleCodec.cpp", "TelemetryEncoder.cpp", "Bmp183Drv.cpp", "Bmp183Array.cpp" ],
+            "cflags": ["-std=c++11", "-Wall", "-fPIC"],
+            "direct_dependent_settings": {
+                "include_dirs": [ "." ],
+                "ldflags": ["-pthread"],
+            },
+        },
         {
             "target_name": "bmp183",
-            "sources": [ "SPIDevice.cpp", "DataManip.cpp", "Bmp183Drv.cpp", "Bmp183Node.cpp" ],
+            "sources": [ "Bmp183Node.cpp", "Bmp183ArrayNode.cpp" ],
+            "dependencies": [ "bmp183_driver" ],
             "cflags": ["-std=c++11", "-Wall"],
         }
+    ],
+    "conditions": [
+        # The benchmark, sampler and tests are only built when asked, as by npm run tools
+        [ "build_tools==1", {
+            "targets": [
+                {
+                    "target_name": "bmp183_bench",
+                    "type": "executable",
+                    "sources": [ "bench/Bmp183Bench.cpp" ],
+                    "dependencies": [ "bmp183_driver" ],
+                    "cflags": ["-std=c++11", "-Wall", "-O2"],
+                },
+                {
+                    "target_name": "bmp183_sampler",
+                    "type": "executable",
+                    "sources": [ "tools/Bmp183Sampler.cpp" ],
+                    "dependencies": [ "bmp183_driver" ],
+                    "cflags": ["-std=c++11", "-Wall", "-O2"],
+                },
+                {
+                    "target_name": "bmp183_test",
+                    "type": "executable",
+                    "sources": [ "test/Bmp183ArrayTest.cpp" ],
+                    "dependencies": [ "bmp183_driver" ],
+                    "cflags": ["-std=c++11", "-Wall", "-O2"],
+                }
+            ]
+        } ]
     ]
 }
 
@@ -0,0 +1,98 @@
+/**
+ * \file Bmp183ArrayTest.cpp
+ *
+ *  Regression tests of Bmp183Array reads against the emulator.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * Checks of array reads that overlap other conversions on the same members, which must still
+ * wait out each member's own conversion time. Hardware is replaced by Bmp183Emulator.
+ *
+ *   bmp183_test
+ *
+ * Prints each check as it runs, and exits non-zero if any fails.
+ */
+
+#include <stdio.h>
+#include <mutex>
+#include <thread>
+#include "../Bmp183Array.h"
+#include "../Bmp183Emulator.h"
+
+static const int numMembers = 3;
+static const int readsPerThread = 20;
+
+// The emulator sits at 1013.25 hPa and 20 C, so anything far off is a stale data register
+static bool plausible(const bmp183_fused_sample &fused) {
+    return (fused.fused == numMembers) &&
+           (fused.pressure > 95000) && (fused.pressure < 106000) &&
+           (fused.temperature > 1000) && (fused.temperature < 3500);
+}
+
+static Bmp183Array* createArray() {
+    Bmp183Array *array = new Bmp183Array();
+    
+    for (int i = 0; i < numMembers; i++) {
+        array->addMember(new Bmp183Drv(new Bmp183Emulator(), 0, BMP183_MODE_ULTRAHIGHRES));
+    }
+    
+    return array;
+}
+
+// Reads the array from several threads at once, counting the fused samples that are implausible
+static int overlappingReads(Bmp183Array *array, int threads) {
+    std::mutex resultMutex;
+    std::thread readers[4];
+    int bad = 0;
+    
+    for (int t = 0; t < threads; t++) {
+        readers[t] = std::thread([&] {
+            for (int i = 0; i < readsPerThread; i++) {
+                bmp183_fused_sample fused;
+                bmp183_member_sample members[maxArrayMembers];
+                bool read = array->read(fused, members);
+                
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (!read || !plausible(fused)) {
+                    bad++;
+                }
+            }
+        });
+    }
+    
+    for (int t = 0; t < threads; t++) {
+        readers[t].join();
+    }
+    
+    return bad;
+}
+
+static bool check(const char *name, int bad, int reads) {
+    printf("%-48s %s (%d of %d reads bad)\n", name, (bad == 0) ? "ok" : "FAILED", bad, reads);
+    return (bad == 0);
+}
+
+int main() {
+    bool passed = true;
+    
+    Bmp183Array *array = createArray();
+    passed &= check("two overlapping array reads", overlappingReads(array, 2), 2 * readsPerThread);
+    
+    // A member's own sampler holds its bus between steps of the array read
+    array->getMember(0)->startSampling(10, 30);
+    passed &= check("array read while a member samples", overlappingReads(array, 1), readsPerThread);
+    array->getMember(0)->stopSampling();
+    
+    delete array;
+    
+    return passed ? 0 : 1;
+}
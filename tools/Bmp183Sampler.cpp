@@ -0,0 +1,210 @@
+/**
+ * \file Bmp183Sampler.cpp
+ *
+ *  Standalone sampler on the driver library, without Node.
+ *  Copyright (c) 2026 Agilatech. All rights reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+
+/*
+ * Standalone sampler, for loggers which do not run Node, and as a baseline for the overhead
+ * of the addon. Samples as fast as the device allows, or at a fixed rate, and writes each
+ * sample to stdout or a file. A device under /dev/i2c is taken to be a BMP085 or BMP180.
+ *
+ *   bmp183_sampler [--device=path|emulator] [--mode=0-3] [--altitude=m] [--rate=hz]
+ *                  [--duration=s] [--count=n] [--format=csv|binary] [--output=file]
+ *                  [--capture=file] [--trace=file]
+ *
+ * CSV has one line per sample of epoch seconds, sea level pressure in hPa, temperature in C
+ * and the mode. Binary is the SampleCodec stream. A capture of raw values for Bmp183Replay
+ * can be taken alongside either. The achieved rate is reported on stderr at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include "../Bmp183Drv.h"
+#include "../SampleCodec.h"
+#include "../Trace.h"
+
+static std::atomic<bool> stopping(false);
+
+static void stop(int signal) {
+    stopping = true;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [--device=path|emulator] [--mode=0-3] [--altitude=m] [--rate=hz] [--duration=s]\n"
+                    "       [--count=n] [--format=csv|binary] [--output=file] [--capture=file]\n"
+                    "       [--trace=file]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    
+    std::string device = "/dev/spidev1.0";
+    std::string output;
+    std::string capture;
+    std::string tracefile;
+    int mode = BMP183_MODE_ULTRAHIGHRES;
+    int altitude = 0;
+    double rate = 0;
+    double duration = 0;
+    uint64_t count = 0;
+    bool binary = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--device=", 9) == 0) {
+            device = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--mode=", 7) == 0) {
+            mode = atoi(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "--altitude=", 11) == 0) {
+            altitude = atoi(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--rate=", 7) == 0) {
+            rate = atof(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "--duration=", 11) == 0) {
+            duration = atof(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--count=", 8) == 0) {
+            count = strtoull(argv[i] + 8, 0, 10);
+        }
+        else if (strcmp(argv[i], "--format=csv") == 0) {
+            binary = false;
+        }
+        else if (strcmp(argv[i], "--format=binary") == 0) {
+            binary = true;
+        }
+        else if (strncmp(argv[i], "--output=", 9) == 0) {
+            output = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--capture=", 10) == 0) {
+            capture = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            tracefile = argv[i] + 8;
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if ((mode < 0) || (mode >= numModes) || (rate < 0) || (duration < 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+    
+    FILE *out = output.empty() ? stdout : fopen(output.c_str(), binary ? "wb" : "w");
+    
+    if (!out) {
+        fprintf(stderr, "Can't open %s: %s\n", output.c_str(), strerror(errno));
+        return 1;
+    }
+    
+    if (!tracefile.empty()) {
+        trace::start(trace::defaultEventsPerThread);
+        trace::setThreadName("sampler main");
+    }
+    
+    Bmp183Drv *driver = Bmp183Drv::create(device, altitude, mode);
+    
+    if (!driver->isActive()) {
+        delete driver;
+        return 1;
+    }
+    
+    if (!capture.empty() && !driver->startRecording(capture)) {
+        delete driver;
+        return 1;
+    }
+    
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    
+    SampleEncoder encoder;
+    uint8_t encoded[SampleEncoder::maxEncodedSize];
+    uint64_t taken = 0, failed = 0, written = 0;
+    
+    if (!binary) {
+        written += fprintf(out, "timestamp,pressure,temperature,mode\n");
+    }
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point next = start;
+    std::chrono::steady_clock::duration interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(rate > 0 ? 1.0 / rate : 0));
+    
+    while (!stopping && ((count == 0) || (taken < count))) {
+        if ((duration > 0) && (std::chrono::steady_clock::now() - start >= std::chrono::duration<double>(duration))) {
+            break;
+        }
+        
+        if (rate > 0) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+        }
+        
+        bmp183_sample sample;
+        
+        if (!driver->readSample(sample)) {
+            failed++;
+            continue;
+        }
+        
+        taken++;
+        
+        if (binary) {
+            size_t length = encoder.encode(sample, encoded);
+            written += fwrite(encoded, 1, length, out);
+        }
+        else {
+            written += fprintf(out, "%lld.%06lld,%.2f,%.2f,%d\n",
+                               (long long)(sample.timestamp / 1000000), (long long)(sample.timestamp % 1000000),
+                               Bmp183Drv::seaLevelPressure(sample.pressure / 100.0F, altitude),
+                               sample.temperature / 100.0F, sample.mode);
+        }
+    }
+    
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    fflush(out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    
+    delete driver;
+    
+    if (!tracefile.empty()) {
+        trace::stop();
+        
+        if (!trace::writeJson(tracefile)) {
+            fprintf(stderr, "Can't write trace to %s\n", tracefile.c_str());
+        }
+        else if (trace::getDropped() > 0) {
+            fprintf(stderr, "Trace full, %llu spans dropped\n", (unsigned long long)trace::getDropped());
+        }
+    }
+    
+    fprintf(stderr, "%llu samples in %.3f s, %.2f Hz achieved, %llu failed, %llu bytes written\n",
+            (unsigned long long)taken, elapsed, elapsed > 0 ? taken / elapsed : 0,
+            (unsigned long long)failed, (unsigned long long)written);
+    
+    return 0;
+}